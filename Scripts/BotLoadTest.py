@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""
+Capacity test of the dedicated server with headless bot clients, on one Linux machine.
+
+For each bot count, starts WorkshopUEServer with a CSV capture of the WorkshopUE stats,
+connects that many headless clients played by AWorkshopUEBot, lets them play, stops everything
+and reports the server tick time, memory and bandwidth read from the capture:
+
+	Scripts/BotLoadTest.py --server Packaged/LinuxServer/WorkshopUEServer.sh \
+		--client Packaged/LinuxNoEditor/WorkshopUE.sh --map /Game/Maps/Level1
+
+The tick time is the frame time without the idle time waiting for the server tick rate.
+The summary is printed and written to <out>/summary.csv, the captures and logs of each run are kept next to it.
+The clients share the machine with the server: keep their frame rate low and check that the
+machine isn't saturated before reading a tick time increase as a server cost.
+"""
+
+import argparse
+import csv
+import os
+import signal
+import subprocess
+import sys
+import time
+
+
+def parse_args():
+	parser = argparse.ArgumentParser(description="Dedicated server load test with headless bot clients.")
+	parser.add_argument("--server", required=True, help="Dedicated server launcher, e.g. LinuxServer/WorkshopUEServer.sh")
+	parser.add_argument("--client", required=True, help="Game launcher, e.g. LinuxNoEditor/WorkshopUE.sh")
+	parser.add_argument("--map", required=True, help="Map loaded by the server")
+	parser.add_argument("--bots", default="1,2,4,8,16,32,64", help="Bot counts, comma separated")
+	parser.add_argument("--duration", type=float, default=60.0, help="Seconds measured once every bot is connected")
+	parser.add_argument("--warmup", type=float, default=10.0, help="Seconds ignored once every bot is connected")
+	parser.add_argument("--connect-timeout", type=float, default=120.0, help="Seconds to wait for the bots to connect")
+	parser.add_argument("--spawn-interval", type=float, default=0.5, help="Seconds between two client launches")
+	parser.add_argument("--client-max-fps", type=int, default=20, help="Frame rate cap of the clients")
+	parser.add_argument("--port", type=int, default=7777)
+	parser.add_argument("--seed", type=int, default=1, help="Seed of the first bot, the next ones are incremented")
+	parser.add_argument("--out", default="Saved/LoadTest", help="Output directory")
+	return parser.parse_args()
+
+
+def launch(command, log_path):
+	log = open(log_path, "w")
+	return subprocess.Popen(command, stdout=log, stderr=subprocess.STDOUT, stdin=subprocess.DEVNULL, start_new_session=True)
+
+
+def stop(processes, timeout=20.0):
+	# SIGINT lets the engine exit cleanly, the CSV capture is flushed on shutdown.
+	for process in processes:
+		if process.poll() is None:
+			os.killpg(process.pid, signal.SIGINT)
+
+	deadline = time.time() + timeout
+	for process in processes:
+		try:
+			process.wait(max(0.0, deadline - time.time()))
+		except subprocess.TimeoutExpired:
+			os.killpg(process.pid, signal.SIGKILL)
+			process.wait()
+
+
+def read_rows(path):
+	if not os.path.exists(path):
+		return []
+	with open(path, newline="") as file:
+		return list(csv.DictReader(file))
+
+
+def connection_count(path):
+	"""Client connections of the server in the last frame of the capture written so far, 0 if none is written."""
+	rows = read_rows(path)
+	return int(rows[-1]["NetConnections"]) if rows else 0
+
+
+def percentile(values, fraction):
+	ordered = sorted(values)
+	return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def summarize(rows, bots, warmup):
+	# Measured frames: every bot connected, after the warm up.
+	measured = []
+	elapsed = None
+	for row in rows:
+		if int(row["NetConnections"]) < bots:
+			elapsed = None
+			continue
+		elapsed = 0.0 if elapsed is None else elapsed + float(row["frameMs"]) / 1000.0
+		if elapsed >= warmup:
+			measured.append(row)
+
+	if not measured:
+		return None
+
+	tick = [float(row["frameMs"]) - float(row["idleMs"]) for row in measured]
+	out_bytes = [int(row["NetOutBytesPerSecond"]) for row in measured]
+	in_bytes = [int(row["NetInBytesPerSecond"]) for row in measured]
+	memory = [int(row["UsedMemoryMB"]) for row in measured]
+
+	return {
+		"bots": bots,
+		"frames": len(measured),
+		"tickMeanMs": sum(tick) / len(tick),
+		"tickP95Ms": percentile(tick, 0.95),
+		"tickMaxMs": max(tick),
+		"memoryMeanMB": sum(memory) / len(memory),
+		"memoryMaxMB": max(memory),
+		"outKBps": sum(out_bytes) / len(out_bytes) / 1024.0,
+		"inKBps": sum(in_bytes) / len(in_bytes) / 1024.0,
+		"outKBpsPerBot": sum(out_bytes) / len(out_bytes) / 1024.0 / bots,
+	}
+
+
+def run(args, bots, run_dir):
+	os.makedirs(run_dir, exist_ok=True)
+	capture = os.path.join(run_dir, "server.csv")
+	if os.path.exists(capture):
+		os.remove(capture)
+
+	server = launch([args.server, args.map, "-port=%d" % args.port, "-WorkshopBotServer",
+		"-WorkshopCsv=%s" % capture, "-unattended", "-log"], os.path.join(run_dir, "server.log"))
+	clients = []
+
+	try:
+		# Give the server the time to load the map.
+		time.sleep(5.0)
+
+		for i in range(bots):
+			clients.append(launch([args.client, "127.0.0.1:%d" % args.port, "-nullrhi", "-nosound", "-unattended",
+				"-WorkshopBot=%d" % (args.seed + i), "-ExecCmds=t.MaxFPS %d" % args.client_max_fps, "-log"],
+				os.path.join(run_dir, "client%02d.log" % i)))
+			time.sleep(args.spawn_interval)
+
+		# The capture is flushed every 600 frames, the connections are seen late.
+		deadline = time.time() + args.connect_timeout
+		while connection_count(capture) < bots and time.time() < deadline:
+			if server.poll() is not None:
+				raise RuntimeError("server exited, see %s" % os.path.join(run_dir, "server.log"))
+			time.sleep(2.0)
+
+		time.sleep(args.warmup + args.duration)
+	finally:
+		stop(clients)
+		stop([server])
+
+	return summarize(read_rows(capture), bots, args.warmup)
+
+
+def main():
+	args = parse_args()
+	out = os.path.abspath(args.out)
+	os.makedirs(out, exist_ok=True)
+
+	results = []
+	for bots in [int(count) for count in args.bots.split(",")]:
+		print("%d bots..." % bots, flush=True)
+		result = run(args, bots, os.path.join(out, "bots%02d" % bots))
+
+		if result is None:
+			print("  no frame with %d connected bots, see %s" % (bots, out), flush=True)
+			continue
+
+		results.append(result)
+		print("  tick %.2f ms (p95 %.2f, max %.2f), memory %d MB, out %.1f KB/s (%.2f per bot), in %.1f KB/s" % (
+			result["tickMeanMs"], result["tickP95Ms"], result["tickMaxMs"], result["memoryMaxMB"],
+			result["outKBps"], result["outKBpsPerBot"], result["inKBps"]), flush=True)
+
+	if not results:
+		return 1
+
+	with open(os.path.join(out, "summary.csv"), "w", newline="") as file:
+		writer = csv.DictWriter(file, fieldnames=list(results[0].keys()))
+		writer.writeheader()
+		writer.writerows(results)
+
+	print("Summary written to %s" % os.path.join(out, "summary.csv"))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
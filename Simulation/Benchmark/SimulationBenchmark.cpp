@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GunPowers.h"
+#include "TransformablePowers.h"
+#include "TweenKernel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/*
+ * Benchmark of the simulation library, without the engine.
+ * Usage: SimulationBenchmark [frames], results are printed as "name count ns/op".
+ */
+namespace
+{
+	using FClock = std::chrono::steady_clock;
+
+	// Keeps the results alive so the measured loops are not optimized out.
+	volatile float Sink;
+
+	double SecondsSince(FClock::time_point start)
+	{
+		return std::chrono::duration<double>(FClock::now() - start).count();
+	}
+
+	void Report(const char* name, int count, double seconds, long long operations)
+	{
+		std::printf("%-24s %8d %10.2f ns/op\n", name, count, seconds * 1.0e9 / (double)operations);
+	}
+
+	void BenchTweens(int count, int frames)
+	{
+		const float deltaTime = 1.0f / 60.0f;
+		const float invDuration = 1.0f / (frames * deltaTime + 1.0f);
+
+		std::vector<double> startTimes(count, 0.0);
+		std::vector<float> invDurations(count, invDuration), alpha(count, 0.0f);
+		std::vector<FTweenVector> from(count, FTweenVector{ 0.0f, 0.0f, 0.0f, 0.0f }), to(count), value(count);
+		for (int i = 0; i < count; i++) {
+			to[i] = { (float)i, 1.0f, 2.0f, 0.0f };
+		}
+
+		const FClock::time_point start = FClock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			TweenKernel::ComputeAlphas(count, (frame + 1) * (double)deltaTime, startTimes.data(), invDurations.data(), alpha.data());
+			TweenKernel::Interpolate(count, alpha.data(), from.data(), to.data(), value.data());
+		}
+		Report("Tweens", count, SecondsSince(start), (long long)count * frames);
+
+		Sink = value[count / 2].x;
+	}
+
+	void BenchPutPowerEffect(int count, int frames)
+	{
+		std::vector<FTransformablePowers> transformables(count);
+		FGunPowers gun;
+		gun.GetStates().values[0] = Powers::GetEffect(0);
+
+		// The power is passed from transformable to transformable.
+		const FClock::time_point start = FClock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			for (FTransformablePowers& transformable : transformables) {
+				transformable.PutPowerEffect(0, gun);
+				transformable.ApplyTweenValue(0, transformable.GetPower(0).newValue, true);
+			}
+		}
+		Report("PutPowerEffect", count, SecondsSince(start), (long long)count * frames);
+
+		Sink = (float)gun.ConsumeChanges();
+	}
+
+	void BenchSnapshots(int count, int frames)
+	{
+		std::vector<FTransformablePowers> transformables(count);
+		std::vector<FTransformableSnapshot> snapshots(count);
+
+		const FClock::time_point start = FClock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			for (int i = 0; i < count; i++) {
+				transformables[i].CaptureSnapshot(snapshots[i]);
+				transformables[i].TransformEffect(frame % Powers::Count);
+				transformables[i].RestoreSnapshot(snapshots[i]);
+			}
+		}
+		Report("SnapshotRestore", count, SecondsSince(start), (long long)count * frames);
+
+		Sink = transformables[0].GetChannelOffset(ETransformChannel::Location).x;
+	}
+
+	void BenchGunCycling(int count, int frames)
+	{
+		FGunPowers gun;
+		gun.Equip();
+		for (int i = 0; i < Powers::Count; i++) {
+			gun.Unlock(i);
+		}
+
+		long long switches = 0;
+
+		const FClock::time_point start = FClock::now();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			for (int i = 0; i < count; i++) {
+				switches += gun.SwitchTo(i & 1 ? gun.GetNextPower() : gun.GetPreviousPower());
+				gun.SetAvailable(gun.GetCurrentPower());
+				switches += gun.TryToUse();
+			}
+		}
+		Report("GunCycling", count, SecondsSince(start), (long long)count * frames);
+
+		Sink = (float)switches;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int frames = argc > 1 ? std::atoi(argv[1]) : 100;
+
+	for (int count : { 1000, 10000, 100000 })
+	{
+		BenchTweens(count, frames);
+		BenchPutPowerEffect(count, frames);
+		BenchSnapshots(count, frames);
+		BenchGunCycling(count, frames);
+	}
+	return 0;
+}
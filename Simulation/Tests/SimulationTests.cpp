@@ -0,0 +1,304 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GunPowers.h"
+#include "TransformablePowers.h"
+
+#include <cstdio>
+
+/*
+ * Unit tests of the simulation library, without the engine.
+ * Run by ctest, or directly: SimulationTests. Failed checks are printed, the exit code is the number of failures.
+ */
+namespace
+{
+	int Failures = 0;
+
+	void Check(bool bCondition, const char* expression, const char* test, int line)
+	{
+		if (!bCondition) {
+			std::printf("%s:%d: check failed: %s\n", test, line, expression);
+			Failures++;
+		}
+	}
+
+	#define SIM_CHECK(condition) Check((condition), #condition, __func__, __LINE__)
+
+	const FSimVector Zero = { 0.0f, 0.0f, 0.0f };
+
+	void TestGunEquip()
+	{
+		FGunPowers gun;
+		SIM_CHECK(!gun.IsEquipped());
+		SIM_CHECK(!gun.IsEnabled());
+		SIM_CHECK(gun.GetCurrentPower() == -1);
+
+		gun.Equip();
+		SIM_CHECK(gun.IsEnabled());
+		SIM_CHECK(gun.GetCurrentPower() == 0);
+		SIM_CHECK(gun.GetStates().IsUnlocked(0));
+		SIM_CHECK(!gun.GetStates().IsAvailable(0));
+		SIM_CHECK(gun.ConsumeChanges() == 1u);
+		SIM_CHECK(gun.GetChanges() == 0u);
+	}
+
+	void TestGunAbsorbAndFire()
+	{
+		FGunPowers gun;
+		gun.Equip();
+		gun.ConsumeChanges();
+
+		// Nothing to fire before an absorb.
+		SIM_CHECK(!gun.TryToUse());
+		SIM_CHECK(gun.GetChanges() == 0u);
+
+		gun.Absorb();
+		SIM_CHECK(gun.GetStates().IsAvailable(0));
+		SIM_CHECK(gun.ConsumeChanges() == 1u);
+
+		SIM_CHECK(gun.TryToUse());
+		SIM_CHECK(!gun.GetStates().IsAvailable(0));
+		SIM_CHECK(gun.ConsumeChanges() == 1u);
+
+		// A power is used once per absorb.
+		SIM_CHECK(!gun.TryToUse());
+	}
+
+	void TestGunSwitch()
+	{
+		FGunPowers gun;
+
+		// The gun must be equipped to switch.
+		gun.Unlock(1);
+		SIM_CHECK(!gun.SwitchTo(1));
+
+		gun.Equip();
+		SIM_CHECK(!gun.SwitchTo(0));
+		SIM_CHECK(!gun.SwitchTo(2));
+		SIM_CHECK(!gun.SwitchTo(-1));
+		SIM_CHECK(!gun.SwitchTo(Powers::Count));
+
+		SIM_CHECK(gun.SwitchTo(1));
+		SIM_CHECK(gun.GetCurrentPower() == 1);
+
+		// Powers 0 and 1 unlocked, the next and previous powers wrap around.
+		SIM_CHECK(gun.GetNextPower() == 0);
+		SIM_CHECK(gun.GetPreviousPower() == 0);
+
+		gun.Unlock(2);
+		SIM_CHECK(gun.GetNextPower() == 2);
+		SIM_CHECK(gun.GetPreviousPower() == 0);
+	}
+
+	void TestGunAvailability()
+	{
+		FGunPowers gun;
+		gun.Equip();
+		gun.Unlock(1);
+		gun.SetAvailable(0);
+		gun.SetAvailable(1);
+		gun.GetStates().values[1] = Powers::GetEffect(1);
+		gun.ConsumeChanges();
+
+		// Unlocking again makes a power unavailable.
+		gun.Unlock(1);
+		SIM_CHECK(!gun.GetStates().IsAvailable(1));
+		SIM_CHECK(gun.ConsumeChanges() == 2u);
+
+		gun.SetAvailable(Powers::Count);
+		SIM_CHECK(gun.GetChanges() == 0u);
+
+		// Reset keeps the unlocked powers and reports them as changed.
+		gun.SetAvailable(1);
+		gun.ConsumeChanges();
+		gun.Reset();
+		SIM_CHECK(gun.GetStates().availableMask == 0u);
+		SIM_CHECK(gun.GetStates().unlockedMask == 3u);
+		SIM_CHECK(gun.GetStates().values[1] == Zero);
+		SIM_CHECK(gun.ConsumeChanges() == 3u);
+	}
+
+	void TestSetupMask()
+	{
+		FSimVector initialValues[Powers::Count] = { Zero, { 360.0f, 0.0f, 0.0f }, Powers::GetEffect(2) };
+
+		// A full turn has no effect.
+		FTransformablePowers powers;
+		SIM_CHECK(powers.Setup(initialValues) == 4u);
+		SIM_CHECK(powers.GetMask() == 4u);
+		SIM_CHECK(!powers.HasPower(1));
+		SIM_CHECK(powers.HasPower(2));
+		SIM_CHECK(powers.GetPower(2).isModifying);
+		SIM_CHECK(!powers.HasPower(Powers::Count));
+	}
+
+	void TestPutPowerEffectSwap()
+	{
+		FGunPowers gun;
+		gun.Equip();
+		gun.GetStates().values[0] = Powers::GetEffect(0);
+		gun.ConsumeChanges();
+
+		FTransformablePowers first;
+		FTransformablePowers second;
+
+		// The gun gives its value to an empty transformable.
+		first.PutPowerEffect(0, gun);
+		SIM_CHECK(first.GetPower(0).newValue == Powers::GetEffect(0));
+		SIM_CHECK(first.GetPower(0).isModifying);
+		SIM_CHECK(first.GetMask() == 1u);
+		SIM_CHECK(gun.GetStates().values[0] == Zero);
+		SIM_CHECK(!gun.GetStates().IsAvailable(0));
+		SIM_CHECK(gun.ConsumeChanges() == 1u);
+
+		// The empty value taken back by the gun from another transformable is swapped in.
+		second.PutPowerEffect(0, gun);
+		SIM_CHECK(second.GetMask() == 0u);
+		SIM_CHECK(gun.GetStates().values[0] == Zero);
+		SIM_CHECK(gun.ConsumeChanges() == 1u);
+
+		// A transformable keeping the power gives it back to the gun.
+		gun.GetStates().values[0] = Powers::GetEffect(0);
+		first.PutPowerEffect(0, gun);
+		SIM_CHECK(first.GetMask() == 1u);
+		SIM_CHECK(first.GetPower(0).newValue == Powers::GetEffect(0));
+		SIM_CHECK(gun.GetStates().values[0] == Powers::GetEffect(0));
+		SIM_CHECK(gun.GetStates().IsAvailable(0));
+		SIM_CHECK(gun.ConsumeChanges() == 1u);
+	}
+
+	void TestTweenValues()
+	{
+		FTransformablePowers powers;
+		powers.TransformEffect(0);
+		SIM_CHECK(powers.GetPower(0).isModifying);
+		SIM_CHECK(powers.GetPower(0).newValue == Powers::GetEffect(0));
+
+		const FSimVector half = Powers::GetEffect(0) * 0.5f;
+		powers.ApplyTweenValue(0, half, false);
+		SIM_CHECK(powers.GetChannelOffset(ETransformChannel::Location) == half);
+
+		// A new effect during a tween starts from the current value.
+		powers.TransformEffect(0);
+		SIM_CHECK(powers.GetPower(0).oldValue == half);
+		SIM_CHECK(powers.GetPower(0).newValue == Powers::GetEffect(0) * 2.0f);
+
+		powers.ApplyTweenValue(0, Powers::GetEffect(0) * 2.0f, true);
+		SIM_CHECK(!powers.GetPower(0).isModifying);
+		SIM_CHECK(powers.GetPower(0).oldValue == Powers::GetEffect(0) * 2.0f);
+	}
+
+	void TestSnapshotRestore()
+	{
+		FSimVector initialValues[Powers::Count] = { Powers::GetEffect(0), Zero, Zero };
+
+		FTransformablePowers powers;
+		powers.Setup(initialValues);
+		powers.ApplyTweenValue(0, Powers::GetEffect(0), true);
+
+		// A tween in progress is recorded at its end.
+		powers.TransformEffect(1);
+		FTransformableSnapshot snapshot;
+		powers.CaptureSnapshot(snapshot);
+		SIM_CHECK(snapshot.values[1] == Powers::GetEffect(1));
+		SIM_CHECK(snapshot.values[0] == Powers::GetEffect(0));
+		SIM_CHECK(snapshot.powerMask == 1u);
+
+		FGunPowers gun;
+		powers.PutPowerEffect(0, gun);
+		powers.SetNewValue(2, Powers::GetEffect(2));
+		SIM_CHECK(powers.GetMask() == 4u);
+
+		powers.RestoreSnapshot(snapshot);
+		SIM_CHECK(powers.GetMask() == 1u);
+		for (int i = 0; i < Powers::Count; i++) {
+			const FPowerValue& power = powers.GetPower(i);
+			SIM_CHECK(!power.isModifying);
+			SIM_CHECK(power.oldValue == snapshot.values[i]);
+			SIM_CHECK(power.actualValue == snapshot.values[i]);
+			SIM_CHECK(power.newValue == snapshot.values[i]);
+		}
+	}
+
+	void TestMaskScan()
+	{
+		// Against a scan of the powers one by one, for every mask and every selected power.
+		for (uint32_t mask = 0; mask <= Powers::AllMask; mask++)
+		{
+			for (int index = -1; index < Powers::Count; index++)
+			{
+				int next = -1;
+				int previous = -1;
+				for (int step = 1; step <= Powers::Count && next == -1; step++) {
+					const int candidate = (index + step) % Powers::Count;
+					next = (mask & (1u << candidate)) != 0 ? candidate : -1;
+				}
+				for (int step = 1; step <= Powers::Count && previous == -1; step++) {
+					const int candidate = ((index < 0 ? 0 : index) - step + Powers::Count * 2) % Powers::Count;
+					previous = (mask & (1u << candidate)) != 0 ? candidate : -1;
+				}
+
+				SIM_CHECK(Powers::NextInMask(mask, index) == next);
+				SIM_CHECK(Powers::PreviousInMask(mask, index) == previous);
+			}
+		}
+
+		// Masks up to 32 powers.
+		SIM_CHECK(Powers::NextInMask(0x80000001u, 0) == 31);
+		SIM_CHECK(Powers::NextInMask(0x80000001u, 31) == 0);
+		SIM_CHECK(Powers::PreviousInMask(0x80000001u, 0) == 31);
+		SIM_CHECK(Powers::PreviousInMask(0x80000001u, 31) == 0);
+	}
+
+	bool SameColor(const FPowerColor& a, const FPowerColor& b)
+	{
+		return a.r == b.r && a.g == b.g && a.b == b.b;
+	}
+
+	void TestMaskColors()
+	{
+		SIM_CHECK(SameColor(Powers::GetMaskColor(0), { 0.0f, 0.0f, 0.0f }));
+		SIM_CHECK(SameColor(Powers::GetMaskColor(Powers::AllMask), { 1.0f, 1.0f, 1.0f }));
+
+		// A power alone has its own color.
+		for (int i = 0; i < Powers::Count; i++) {
+			SIM_CHECK(SameColor(Powers::GetMaskColor(1u << i), Powers::Table[i].color));
+		}
+
+		SIM_CHECK(SameColor(Powers::GetMaskColor(3u), { 1.0f, 1.0f, 0.0f }));
+	}
+
+	void TestSetNewValueMask()
+	{
+		FTransformablePowers powers;
+		powers.SetNewValue(1, Powers::GetEffect(1));
+		SIM_CHECK(powers.GetMask() == 2u);
+
+		powers.SetNewValue(1, { -360.0f, 0.0f, 0.0f });
+		SIM_CHECK(powers.GetMask() == 0u);
+		SIM_CHECK(powers.GetPower(1).isModifying);
+
+		powers.StopAtOldValues();
+		SIM_CHECK(!powers.GetPower(1).isModifying);
+		SIM_CHECK(powers.GetPower(1).actualValue == Zero);
+	}
+}
+
+int main()
+{
+	TestGunEquip();
+	TestGunAbsorbAndFire();
+	TestGunSwitch();
+	TestGunAvailability();
+	TestSetupMask();
+	TestPutPowerEffectSwap();
+	TestTweenValues();
+	TestSnapshotRestore();
+	TestSetNewValueMask();
+	TestMaskColors();
+	TestMaskScan();
+
+	if (Failures == 0) {
+		std::printf("All simulation tests passed\n");
+	}
+	return Failures;
+}
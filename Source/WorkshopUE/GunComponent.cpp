@@ -1,29 +1,59 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "GunComponent.h"
+#include "ProjectilePool.h"
+#include "WorkshopUEProjectile.h"
+#include "WorkshopUEStats.h"
 #include "Engine.h"
+#include "Transformable.h"
+#include "UnrealNetwork.h"
+#include "Engine/NetSerialization.h"
 
-// Sets default values for this component's properties
-UGunComponent::UGunComponent()
+// Sequences wrap around, a sequence is acknowledged if it is not after the acknowledged one.
+static bool IsAcknowledged(uint8 sequence, uint8 ackSequence)
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
+	return (int8)(sequence - ackSequence) <= 0;
+}
 
-	// Gun is not equipped by default
-	bEquipped = false;
+bool FGunNetState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	static_assert(Powers::Count <= 8, "Power masks are replicated as uint8.");
 
-	// Setup gun powers.
-	{
-		powersStates.bUnlocked.Init(false, 3);
-		powersStates.bAvailable.Init(false, 3);
+	Ar.SerializeBits(&unlockedMask, Powers::Count);
+	Ar.SerializeBits(&availableMask, Powers::Count);
+
+	// No power selected is sent as 0.
+	uint32 power = (uint32)(currentPower + 1);
+	Ar.SerializeInt(power, Powers::Count + 1);
+	currentPower = (int8)power - 1;
+
+	uint8 equipped = bEquipped ? 1 : 0;
+	Ar.SerializeBits(&equipped, 1);
+	bEquipped = equipped != 0;
 
-		powersStates.position = std::make_shared<FVector>(FVector::ZeroVector);
-		powersStates.rotation = std::make_shared<FRotator>(FRotator::ZeroRotator);
-		powersStates.scale = std::make_shared<FVector>(FVector::ZeroVector);
+	Ar << ackSequence;
+
+	bOutSuccess = true;
+	for (FVector& value : values) {
+		bOutSuccess &= SerializePackedVector<100, 30>(value, Ar);
 	}
 
-	currentPower = -1;
+	return true;
+}
+
+// Sets default values for this component's properties
+UGunComponent::UGunComponent()
+{
+	// Power changes are notified through a next tick timer, the gun never ticks.
+	PrimaryComponentTick.bCanEverTick = false;
+
+	bBroadcastScheduled = false;
+
+	bReplicates = true;
+	predictionSequence = 0;
+
+	projectilePoolSize = 8;
+	bBatchProjectileSimulation = false;
 }
 
 
@@ -34,162 +64,276 @@ void UGunComponent::BeginPlay()
 }
 
 
-// Called every frame
-void UGunComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+void UGunComponent::SwitchToPower(int index)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	WORKSHOPUE_SCOPE_CYCLE(GunPowers);
 
-	// Rotate gun tubes continuously.
-	/*
-	if (gunTubes != nullptr) {
+	if (powers.SwitchTo(index)) {
 		FRotator currentRot = gunTubes->RelativeRotation;
-		currentRot.Yaw -= DeltaTime * 100.0f;
+		currentRot.Yaw = Powers::Table[index].tubeYaw;
 		gunTubes->SetRelativeRotation(currentRot);
+
+		UpdateNetState();
 	}
-	*/
 }
 
-void UGunComponent::SwitchToPower(int index)
+void UGunComponent::SetEquipped(bool bInEquipped)
 {
-	if (index == -1 || !bEquipped) {
+	powers.SetEquipped(bInEquipped);
+	UpdateNetState();
+}
+
+void UGunComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Only the owner displays the powers of its gun.
+	DOREPLIFETIME_CONDITION(UGunComponent, netState, COND_OwnerOnly);
+}
+
+void UGunComponent::UpdateNetState()
+{
+	if (GetOwnerRole() != ROLE_Authority) {
 		return;
 	}
 
-	// Check if power is unlocked and power is not already selected.
-	if (powersStates.bUnlocked[index] && currentPower != index) {
-		currentPower = index;
-		
-		FRotator currentRot = gunTubes->RelativeRotation;
-		currentRot.Yaw = 60.0f - index*120.0f;
-		gunTubes->SetRelativeRotation(currentRot);
+	const FPowerStates& states = powers.GetStates();
+	netState.unlockedMask = (uint8)states.unlockedMask;
+	netState.availableMask = (uint8)states.availableMask;
+	netState.currentPower = (int8)powers.GetCurrentPower();
+	netState.bEquipped = powers.IsEquipped();
+
+	for (int i = 0; i < Powers::Count; i++) {
+		netState.values[i] = Powers::ToVector(states.values[i]);
 	}
 }
 
-void UGunComponent::PreviousPower()
+void UGunComponent::OnRep_NetState()
 {
-	bool powerIndexFound = false;
+	// Actions processed by the server are in its state.
+	int acknowledged = 0;
+	while (acknowledged < predictions.Num() && IsAcknowledged(predictions[acknowledged].sequence, netState.ackSequence)) {
+		acknowledged++;
+	}
+	predictions.RemoveAt(0, acknowledged, false);
 
-	int previousPowerIndex = currentPower;
-	int timeout = 0;
+	ApplyNetState();
+}
 
-	do {
-		previousPowerIndex = previousPowerIndex - 1;
+void UGunComponent::ApplyNetState()
+{
+	FPowerStates& states = powers.GetStates();
+	const uint32 previousUnlocked = states.unlockedMask;
+	const uint32 previousAvailable = states.availableMask;
 
-		if (previousPowerIndex < 0) {
-			previousPowerIndex = 2;
-		}
+	states.unlockedMask = netState.unlockedMask;
+	states.availableMask = netState.availableMask;
+	powers.SetEquipped(netState.bEquipped);
+
+	for (int i = 0; i < Powers::Count; i++) {
+		states.values[i] = Powers::ToSimVector(netState.values[i]);
+	}
+
+	for (const FGunPrediction& prediction : predictions)
+	{
+		const uint32 bit = 1u << prediction.powerIndex;
+		states.availableMask = prediction.bAvailable ? states.availableMask | bit : states.availableMask & ~bit;
 
-		if (powersStates.bUnlocked[previousPowerIndex]) {
-			powerIndexFound = true;
+		if (prediction.bHasValue) {
+			states.values[prediction.powerIndex] = prediction.value;
 		}
+	}
 
-		timeout++;
+	uint32 changed = (states.unlockedMask ^ previousUnlocked) | (states.availableMask ^ previousAvailable);
 
-	} while (!powerIndexFound && timeout < 3);
+	// Turns the tubes like a local switch.
+	if (netState.currentPower != -1) {
+		SwitchToPower(netState.currentPower);
+	}
 
-	SwitchToPower(previousPowerIndex);
+	while (changed != 0)
+	{
+		powers.MarkChanged((int)FMath::CountTrailingZeros(changed));
+		changed &= changed - 1;
+	}
+	SchedulePowerChanges();
 }
 
-void UGunComponent::NextPower()
+void UGunComponent::RecordPrediction(uint8 sequence, int index, bool bHasValue, ATransformable* target)
+{
+	const FPowerStates& states = powers.GetStates();
+
+	FGunPrediction& prediction = predictions[predictions.AddDefaulted()];
+	prediction.sequence = sequence;
+	prediction.powerIndex = index;
+	prediction.bAvailable = states.IsAvailable(index);
+	prediction.bHasValue = bHasValue;
+	prediction.value = states.values[index];
+	prediction.target = target;
+}
+
+void UGunComponent::AcknowledgePrediction(uint8 sequence, bool bAccepted)
 {
-	bool powerIndexFound = false;
+	// The acknowledgement and the result of the action are sent together.
+	netState.ackSequence = sequence;
+	UpdateNetState();
 
-	int nextPowerIndex = currentPower;
-	int timeout = 0;
+	if (!bAccepted) {
+		ClientRejectPrediction(sequence);
+	}
+}
 
-	do {
-		nextPowerIndex = (nextPowerIndex + 1) % 3;
+void UGunComponent::ClientRejectPrediction_Implementation(uint8 sequence)
+{
+	const int index = predictions.IndexOfByPredicate([sequence](const FGunPrediction& prediction) { return prediction.sequence == sequence; });
 
-		if (powersStates.bUnlocked[nextPowerIndex]) {
-			powerIndexFound = true;
-		}
+	if (index == INDEX_NONE) {
+		return;
+	}
 
-		timeout++;
+	ATransformable* target = predictions[index].target.Get();
+	predictions.RemoveAt(index);
 
-	} while (!powerIndexFound && timeout < 3);
+	if (target != nullptr) {
+		target->Reconcile();
+	}
 
-	SwitchToPower(nextPowerIndex);
+	ApplyNetState();
+}
+
+void UGunComponent::PreviousPower()
+{
+	SwitchToPower(powers.GetPreviousPower());
+}
+
+void UGunComponent::NextPower()
+{
+	SwitchToPower(powers.GetNextPower());
 }
 
 void UGunComponent::EquipGun()
 {
-	bEquipped = true;
+	CreateProjectilePools();
 
 	// Unlock first power and select it.
-	UnlockPower(0);
-	currentPower = 0;
-	SwitchToPower(0);
+	powers.Equip();
+	SchedulePowerChanges();
+}
+
+void UGunComponent::CreateProjectilePools()
+{
+	// Projectiles are spawned by the server and replicated.
+	if (projectilePools.Num() > 0 || GetOwnerRole() != ROLE_Authority) {
+		return;
+	}
+
+	for (int i = 0; i < ProjectileClasses.Num(); i++)
+	{
+		UProjectilePool* pool = nullptr;
+
+		if (ProjectileClasses[i] != nullptr) {
+			pool = NewObject<UProjectilePool>(this);
+			pool->Init(GetWorld(), ProjectileClasses[i], projectilePoolSize);
+		}
+
+		projectilePools.Add(pool);
+	}
+}
+
+AWorkshopUEProjectile* UGunComponent::AcquireProjectile(int index)
+{
+	CreateProjectilePools();
+
+	if (!projectilePools.IsValidIndex(index) || projectilePools[index] == nullptr) {
+		return nullptr;
+	}
+
+	return projectilePools[index]->Acquire();
 }
 
 void UGunComponent::UnlockPower(int index)
 {
-	// Unlock this power ans set it available.
-	powersStates.bUnlocked[index] = true;
-	powersStates.bAvailable[index] = false;
+	WORKSHOPUE_SCOPE_CYCLE(GunPowers);
 
-	SetPowerColor(index, 0.15f);
+	powers.Unlock(index);
+	SchedulePowerChanges();
 }
 
 bool UGunComponent::IsEnable() {
-	return bEquipped && currentPower != -1;
+	return powers.IsEnabled();
 }
 
 bool UGunComponent::TryToUsePower() {
+	WORKSHOPUE_SCOPE_CYCLE(GunPowers);
 
-	if (currentPower == -1 || !powersStates.bAvailable[currentPower]) {
+	if (!powers.TryToUse()) {
 		return false;
 	}
 
-	SetPowerColor(currentPower, 0.15f);
-	
-	powersStates.bAvailable[currentPower] = false;
-
+	SchedulePowerChanges();
 	return true;
 }
 
 void UGunComponent::AbsorbPower() {
 
-	if (currentPower == -1) {
-		return;
-	}
+	powers.Absorb();
+	SchedulePowerChanges();
+}
+
+void UGunComponent::MarkPowerChanged(int index) {
 
-	SetPowerAvailable(currentPower);
+	powers.MarkChanged(index);
+	SchedulePowerChanges();
 }
 
-void UGunComponent::SetPowerColor(int index, float value) {
-	
-	FVector color(
-		index == 0 ? value : 0.0,
-		index == 1 ? value : 0.0,
-		index == 2 ? value : 0.0
-	);
-	OnPowerChanged.Broadcast(index, color);
+void UGunComponent::SchedulePowerChanges() {
+
+	// First change this frame, schedule the notification.
+	if (!bBroadcastScheduled && powers.GetChanges() != 0 && GetWorld() != nullptr) {
+		GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UGunComponent::BroadcastPowerChanges);
+		bBroadcastScheduled = true;
+	}
 }
 
-void UGunComponent::SetPowerAvailable(int index) {
+void UGunComponent::BroadcastPowerChanges() {
+	WORKSHOPUE_SCOPE_CYCLE(GunNotifications);
+
+	bBroadcastScheduled = false;
+	UpdateNetState();
+
+	const uint32 changed = powers.ConsumeChanges();
+	const FPowerStates& states = powers.GetStates();
+
+	OnPowerStatesChanged.Broadcast(states);
 
-	if (index < 0) {
+	if (!OnPowerChanged.IsBound()) {
 		return;
 	}
 
-	powersStates.bAvailable[index] = true;
+	// Locked powers are not displayed.
+	uint32 displayed = changed & (states.unlockedMask | states.availableMask);
 
-	SetPowerColor(index, 1.0f);
-}
-
-void UGunComponent::ResetPowers() {
-	
-	for (int i = 0; i < powersStates.bAvailable.Num(); i++)
+	while (displayed != 0)
 	{
-		powersStates.bAvailable[i] = false;
+		const int index = (int)FMath::CountTrailingZeros(displayed);
+		displayed &= displayed - 1;
 
-		if (powersStates.bUnlocked[i]) {
-			SetPowerColor(i, 0.15f);
-		}
+		const float value = states.IsAvailable(index) ? 1.0f : 0.15f;
+
+		OnPowerChanged.Broadcast(index, Powers::ToVector(Powers::Table[index].color) * value);
 	}
+}
+
+void UGunComponent::SetPowerAvailable(int index) {
+	WORKSHOPUE_SCOPE_CYCLE(GunPowers);
+
+	powers.SetAvailable(index);
+	SchedulePowerChanges();
+}
+
+void UGunComponent::ResetPowers() {
+	WORKSHOPUE_SCOPE_CYCLE(GunPowers);
 
-	// Reset powers.
-	*powersStates.position = FVector::ZeroVector;
-	*powersStates.rotation = FRotator::ZeroRotator;
-	*powersStates.scale = FVector::ZeroVector;
+	powers.Reset();
+	SchedulePowerChanges();
 }
@@ -4,21 +4,83 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
-#include <memory>
+#include "PowerTable.h"
+#include "Simulation/GunPowers.h"
 #include "GunComponent.generated.h"
 
+class ATransformable;
+
+/*
+ * Replicated state of the gun: the power masks, the selected power and the equipped state in a few bits,
+ * the values held by the gun quantized to 1/100 and the last action of the owning client processed by the server.
+ */
 USTRUCT()
-struct FPowerStates {
+struct FGunNetState
+{
+	GENERATED_BODY()
 
-	GENERATED_USTRUCT_BODY()
+	uint8 unlockedMask;
+	uint8 availableMask;
+	int8 currentPower;
+	bool bEquipped;
+	uint8 ackSequence;
+	FVector values[Powers::Count];
+
+	FGunNetState() : unlockedMask(0), availableMask(0), currentPower(-1), bEquipped(false), ackSequence(0)
+	{
+		for (FVector& value : values) {
+			value = FVector::ZeroVector;
+		}
+	}
+
+	bool operator==(const FGunNetState& other) const
+	{
+		for (int i = 0; i < Powers::Count; i++) {
+			if (values[i] != other.values[i]) {
+				return false;
+			}
+		}
+
+		return unlockedMask == other.unlockedMask && availableMask == other.availableMask
+			&& currentPower == other.currentPower && bEquipped == other.bEquipped && ackSequence == other.ackSequence;
+	}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
 
-	TArray<bool> bUnlocked;
-	TArray<bool> bAvailable;
-	std::shared_ptr<FVector> position;
-	std::shared_ptr<FRotator> rotation;
-	std::shared_ptr<FVector> scale;
+template<>
+struct TStructOpsTypeTraits<FGunNetState> : public TStructOpsTypeTraitsBase2<FGunNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
 };
 
+/* Power change predicted by the owning client, replayed over the state of the server until it processes the action. */
+struct FGunPrediction
+{
+	uint8 sequence;
+	int powerIndex;
+
+	/* State of the power after the action, the value is only changed by absorbs. */
+	bool bAvailable;
+	bool bHasValue;
+	FSimVector value;
+
+	/* Transformable changed by the action, rolled back if the server rejects it. */
+	TWeakObjectPtr<ATransformable> target;
+};
+
+/*
+ * Engine adapter of FGunPowers: gun tubes, projectile pools and power change notifications.
+ * The server owns the powers, clients receive them through FGunNetState.
+ *
+ * Prediction: the owning client applies its shots and absorbs right away, numbered by a sequence sent with the action.
+ * Each replicated state is the state of the server with the actions it hasn't processed yet replayed over it.
+ * A rejected action is dropped and its transformable tweens back to the state of the server.
+ */
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class WORKSHOPUE_API UGunComponent : public UActorComponent
 {
@@ -40,11 +102,19 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = Projectile)
 		TArray<TSubclassOf<class AWorkshopUEProjectile>> ProjectileClasses;
 
-	/* Current power selected*/
-	int currentPower;
+	/** Number of projectiles spawned per class when the gun is equipped. */
+	UPROPERTY(EditDefaultsOnly, Category = Projectile)
+		int projectilePoolSize;
+
+	/** Simulate the projectiles in batch in the projectile manager instead of one movement component each. */
+	UPROPERTY(EditDefaultsOnly, Category = Projectile)
+		bool bBatchProjectileSimulation;
+
+	/* Take a projectile of the power from its pool, nullptr if the power has no projectile class. */
+	class AWorkshopUEProjectile* AcquireProjectile(int index);
 
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	/* Current power selected, -1 if none. */
+	int GetCurrentPower() const { return powers.GetCurrentPower(); }
 
 	void PreviousPower();
 
@@ -54,7 +124,9 @@ public:
 
 	void EquipGun();
 
-	bool bEquipped;
+	bool IsEquipped() const { return powers.IsEquipped(); }
+
+	void SetEquipped(bool bInEquipped);
 
 	bool IsEnable();
 
@@ -67,15 +139,75 @@ public:
 
 	void AbsorbPower();
 
-	/* Update color of the power on the gun.*/
-	void SetPowerColor(int index, float value);
+	/* Flag a power as changed, listeners are notified once at the start of the next frame. */
+	void MarkPowerChanged(int index);
+
+	/* Notify the listeners of the changes made directly to the powers, once at the start of the next frame. */
+	void SchedulePowerChanges();
 
 	void ResetPowers();
 
+	/* Native notification, broadcast at most once per frame with the full power states. */
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnPowerStatesChanged, const FPowerStates&);
+
+	FOnPowerStatesChanged OnPowerStatesChanged;
+
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnPowerChanged, uint8, index, FVector, color);
 
+	/* Blueprint bridge, only broadcast if bound, once per changed power with its color on the gun. */
 	UPROPERTY(BlueprintAssignable, category = "CppFunctions")
 	FOnPowerChanged OnPowerChanged;
 
-	FPowerStates powersStates;
+	const FPowerStates& GetPowerStates() const { return powers.GetStates(); }
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/* Power state machine, call SchedulePowerChanges after changing it directly. */
+	FGunPowers& GetPowers() { return powers; }
+
+	/* Sequence number of the next action predicted by the owning client. */
+	uint8 BeginPrediction() { return ++predictionSequence; }
+
+	/* Record the state of a power after a predicted action, with the transformable it changed if any. */
+	void RecordPrediction(uint8 sequence, int index, bool bHasValue, ATransformable* target = nullptr);
+
+	/* Server: the action of a sequence was processed, the owning client rolls it back if it was not accepted. */
+	void AcknowledgePrediction(uint8 sequence, bool bAccepted);
+
+private:
+	FGunPowers powers;
+
+	/* A notification is scheduled for the next frame. */
+	bool bBroadcastScheduled;
+
+	/* State of the powers sent to the owning client. */
+	UPROPERTY(ReplicatedUsing = OnRep_NetState)
+	FGunNetState netState;
+
+	UFUNCTION()
+	void OnRep_NetState();
+
+	/* Copy the powers to the replicated state, server only. */
+	void UpdateNetState();
+
+	/* Set the powers to the replicated state and replay the pending predictions over it. */
+	void ApplyNetState();
+
+	UFUNCTION(Client, Reliable)
+	void ClientRejectPrediction(uint8 sequence);
+
+	/* Last sequence given to a predicted action. */
+	uint8 predictionSequence;
+
+	/* Predicted actions not yet processed by the server, oldest first. */
+	TArray<FGunPrediction> predictions;
+
+	/* Notify the listeners of the powers changed this frame. */
+	void BroadcastPowerChanges();
+
+	/* Projectile pools, one per projectile class. */
+	UPROPERTY()
+	TArray<class UProjectilePool*> projectilePools;
+
+	void CreateProjectilePools();
 };
\ No newline at end of file
@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NetRegionVolume.h"
+#include "EngineUtils.h"
+
+ANetRegionVolume* ANetRegionVolume::Find(UWorld* world, const FVector& location)
+{
+	for (TActorIterator<ANetRegionVolume> it(world); it; ++it) {
+		if (it->EncompassesPoint(location)) {
+			return *it;
+		}
+	}
+	return nullptr;
+}
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Volume.h"
+#include "NetRegionVolume.generated.h"
+
+/*
+ * Room or checkpoint region of a level, used for the relevancy of the transformables.
+ * A transformable inside a region is only relevant to the players viewing from this region
+ * or from a region listing it in visibleRegions. Outside every region, the distance relevancy applies.
+ */
+UCLASS()
+class WORKSHOPUE_API ANetRegionVolume : public AVolume
+{
+	GENERATED_BODY()
+
+public:
+	/** Regions seen from this one, e.g. through a window or an open door. */
+	UPROPERTY(EditAnywhere, Category = Replication)
+	TArray<ANetRegionVolume*> visibleRegions;
+
+	/* Region containing a location, null if none. */
+	static ANetRegionVolume* Find(UWorld* world, const FVector& location);
+
+	/* True if what is in a region is seen from this one. */
+	bool Sees(const ANetRegionVolume* region) const { return region == this || visibleRegions.Contains(region); }
+};
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Simulation/PowerRules.h"
+
+/* Engine conversions of the power values and colors, the rules are in Simulation/PowerRules.h. */
+namespace Powers
+{
+	static_assert(sizeof(FSimVector) == sizeof(FVector), "Power values are laid out like FVector.");
+
+	inline FVector ToVector(const FSimVector& value)
+	{
+		return FVector(value.x, value.y, value.z);
+	}
+
+	inline FSimVector ToSimVector(const FVector& value)
+	{
+		return { value.X, value.Y, value.Z };
+	}
+
+	inline FVector ToVector(const FPowerColor& color)
+	{
+		return FVector(color.r, color.g, color.b);
+	}
+}
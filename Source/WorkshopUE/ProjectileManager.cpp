@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ProjectileManager.h"
+#include "WorkshopUEProjectile.h"
+#include "WorkshopUECharacter.h"
+#include "WorldManager.h"
+#include "WorkshopUEStats.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Components/SphereComponent.h"
+
+static const FName ProjectileProfileName(TEXT("Projectile"));
+
+// Distance kept between a bounced projectile and the surface, in cm.
+static const float BounceSkin = 1.0f;
+
+// Sets default values
+AProjectileManager::AProjectileManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Only tick while some projectiles are alive.
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	maxBouncesPerFrame = 4;
+}
+
+AProjectileManager* AProjectileManager::Get(UWorld* world)
+{
+	return FindOrSpawnWorldManager<AProjectileManager>(world);
+}
+
+void AProjectileManager::AddProjectile(AWorkshopUEProjectile* projectile, const FVector& location, const FVector& velocity, float lifespan)
+{
+	const UProjectileMovementComponent* movement = projectile->GetProjectileMovement();
+
+	FSimulatedProjectile simulated;
+	simulated.location = location;
+	simulated.velocity = velocity;
+	simulated.remainingLife = lifespan;
+	simulated.radius = projectile->GetCollisionComp()->GetScaledSphereRadius();
+	simulated.bounciness = movement->Bounciness;
+	simulated.friction = movement->Friction;
+	simulated.visual = projectile;
+
+	projectiles.Add(simulated);
+
+	SetActorTickEnabled(true);
+}
+
+// Called every frame
+void AProjectileManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	WORKSHOPUE_SCOPE_CYCLE(BatchedProjectiles);
+
+	// Iterate backward, finished projectiles are swapped out of the array.
+	for (int i = projectiles.Num() - 1; i >= 0; i--)
+	{
+		FSimulatedProjectile& projectile = projectiles[i];
+
+		// Visual destroyed with its level.
+		if (projectile.visual == nullptr || projectile.visual->IsPendingKill()) {
+			projectiles.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+
+		const float stepTime = FMath::Min(DeltaTime, projectile.remainingLife);
+		projectile.remainingLife -= DeltaTime;
+
+		if (Advance(projectile, stepTime)) {
+			projectiles.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+
+		if (projectile.remainingLife <= 0.0f) {
+			AWorkshopUEProjectile* visual = projectile.visual;
+			projectiles.RemoveAtSwap(i, 1, false);
+			visual->Expire();
+			continue;
+		}
+
+		projectile.visual->SetActorLocationAndRotation(projectile.location, projectile.velocity.Rotation());
+	}
+
+	if (projectiles.Num() == 0) {
+		SetActorTickEnabled(false);
+	}
+}
+
+bool AProjectileManager::Advance(FSimulatedProjectile& projectile, float DeltaTime)
+{
+	UWorld* world = GetWorld();
+
+	// The projectile profile also blocks its shooter.
+	FCollisionQueryParams queryParams;
+	queryParams.AddIgnoredActor(projectile.visual);
+	queryParams.AddIgnoredActor(projectile.visual->player);
+
+	const FCollisionShape sphere = FCollisionShape::MakeSphere(projectile.radius);
+
+	float remainingTime = DeltaTime;
+
+	for (int bounce = 0; bounce <= maxBouncesPerFrame && remainingTime > 0.0f; bounce++)
+	{
+		const FVector start = projectile.location;
+		const FVector end = start + projectile.velocity * remainingTime;
+
+		// The whole frame segment is swept, fast projectiles can't tunnel through thin geometry.
+		FHitResult hit;
+		if (!world->SweepSingleByProfile(hit, start, end, FQuat::Identity, ProjectileProfileName, sphere, queryParams)) {
+			projectile.location = end;
+			return false;
+		}
+
+		// Started inside a surface: move out of it and sweep again, it isn't an impact.
+		if (hit.bStartPenetrating) {
+			projectile.location += hit.Normal * (hit.PenetrationDepth + BounceSkin);
+			continue;
+		}
+
+		projectile.location = hit.Location;
+		remainingTime *= 1.0f - hit.Time;
+
+		if (projectile.visual->HandleImpact(hit.GetActor(), hit.GetComponent())) {
+			return true;
+		}
+
+		// Bounce: reflect the normal part of the velocity, damp the tangent part by friction.
+		const FVector normal = hit.ImpactNormal;
+		const FVector normalVelocity = normal * FVector::DotProduct(projectile.velocity, normal);
+		const FVector tangentVelocity = projectile.velocity - normalVelocity;
+
+		projectile.velocity = tangentVelocity * (1.0f - projectile.friction) - normalVelocity * projectile.bounciness;
+
+		// Step away from the surface so the next sweep doesn't start in penetration.
+		projectile.location = hit.ImpactPoint + normal * (projectile.radius + BounceSkin);
+	}
+
+	return false;
+}
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ProjectileManager.generated.h"
+
+class AWorkshopUEProjectile;
+
+/*
+ * World-level simulation of the projectiles fired in batch mode.
+ * Projectiles fly in straight lines without gravity, so each one is advanced with a single sphere sweep
+ * per frame and bounces are resolved analytically. The projectile actor is only used as a visual.
+ */
+UCLASS(NotPlaceable, Transient)
+class WORKSHOPUE_API AProjectileManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AProjectileManager();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	/* Find the manager of the world, spawn it if it doesn't exist yet. */
+	static AProjectileManager* Get(UWorld* world);
+
+	/* Simulate a projectile until it hits a transformable or its lifespan ends. */
+	void AddProjectile(AWorkshopUEProjectile* projectile, const FVector& location, const FVector& velocity, float lifespan);
+
+	int GetLiveCount() const { return projectiles.Num(); }
+
+	/** Maximum number of bounces resolved for one projectile in a single frame. */
+	UPROPERTY(EditAnywhere, Category = Projectile)
+	int maxBouncesPerFrame;
+
+private:
+	struct FSimulatedProjectile
+	{
+		FVector location;
+		FVector velocity;
+		float remainingLife;
+		float radius;
+		float bounciness;
+		float friction;
+		AWorkshopUEProjectile* visual;
+	};
+
+	TArray<FSimulatedProjectile> projectiles;
+
+	/* Move a projectile along its velocity, return true when it has been consumed by a hit. */
+	bool Advance(FSimulatedProjectile& projectile, float DeltaTime);
+};
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ProjectilePool.h"
+#include "WorkshopUEProjectile.h"
+
+void UProjectilePool::Init(UWorld* inWorld, TSubclassOf<AWorkshopUEProjectile> inProjectileClass, int prewarmCount)
+{
+	world = inWorld;
+	projectileClass = inProjectileClass;
+
+	freeProjectiles.Reserve(prewarmCount);
+
+	for (int i = 0; i < prewarmCount; i++)
+	{
+		AWorkshopUEProjectile* projectile = SpawnProjectile();
+
+		if (projectile) {
+			freeProjectiles.Add(projectile);
+		}
+	}
+}
+
+AWorkshopUEProjectile* UProjectilePool::Acquire()
+{
+	while (freeProjectiles.Num() > 0)
+	{
+		AWorkshopUEProjectile* projectile = freeProjectiles.Pop(false);
+
+		// Projectiles may have been destroyed with their level.
+		if (projectile != nullptr && !projectile->IsPendingKill()) {
+			return projectile;
+		}
+	}
+
+	return SpawnProjectile();
+}
+
+void UProjectilePool::Release(AWorkshopUEProjectile* projectile)
+{
+	freeProjectiles.Add(projectile);
+}
+
+AWorkshopUEProjectile* UProjectilePool::SpawnProjectile()
+{
+	if (world == nullptr || projectileClass == nullptr) {
+		return nullptr;
+	}
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AWorkshopUEProjectile* projectile = world->SpawnActor<AWorkshopUEProjectile>(projectileClass, FVector::ZeroVector, FRotator::ZeroRotator, spawnParams);
+
+	if (projectile) {
+		projectile->pool = this;
+		projectile->Disable();
+	}
+
+	return projectile;
+}
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "ProjectilePool.generated.h"
+
+class AWorkshopUEProjectile;
+
+/*
+ * Pool of projectiles of a single class.
+ * Projectiles are spawned once, then relaunched and returned to the pool instead of being destroyed.
+ */
+UCLASS()
+class WORKSHOPUE_API UProjectilePool : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/* Setup the pool and spawn prewarmCount disabled projectiles. */
+	void Init(UWorld* world, TSubclassOf<AWorkshopUEProjectile> projectileClass, int prewarmCount);
+
+	/* Take a disabled projectile from the pool, spawn one if the pool is empty. */
+	AWorkshopUEProjectile* Acquire();
+
+	/* Give back a disabled projectile to the pool. */
+	void Release(AWorkshopUEProjectile* projectile);
+
+private:
+	AWorkshopUEProjectile* SpawnProjectile();
+
+	UPROPERTY()
+	UWorld* world;
+
+	UPROPERTY()
+	TSubclassOf<AWorkshopUEProjectile> projectileClass;
+
+	UPROPERTY()
+	TArray<AWorkshopUEProjectile*> freeProjectiles;
+};
@@ -0,0 +1,387 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SessionRecorder.h"
+#include "WorkshopUE.h"
+#include "WorkshopUECharacter.h"
+#include "Transformable.h"
+#include "WorldManager.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "RenderCore.h"
+
+static const uint32 SessionMagic = 0x31525357;	// "WSR1"
+static const int32 SessionVersion = 2;
+
+FArchive& operator<<(FArchive& Ar, FSessionEvent& event)
+{
+	uint8 type = (uint8)event.type;
+	Ar << type << event.index;
+	event.type = (ESessionEvent)type;
+
+	// Only checkpoints have a location.
+	if (event.type == ESessionEvent::Checkpoint) {
+		Ar << event.location;
+	}
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FSessionFrame& frame)
+{
+	return Ar << frame.deltaTime << frame.location << frame.rotation << frame.controlRotation << frame.events;
+}
+
+// Sets default values
+ASessionRecorder::ASessionRecorder()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Ticks only while recording or replaying.
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	mode = EMode::Idle;
+	character = nullptr;
+	replayFrame = 0;
+	bApplyingEvent = false;
+	recordedHash = 0;
+}
+
+ASessionRecorder* ASessionRecorder::AttachFromCommandLine(AWorkshopUECharacter* character)
+{
+	FString recordPath;
+	FString replayPath;
+	const bool bRecord = FParse::Value(FCommandLine::Get(), TEXT("WorkshopRecord="), recordPath);
+	const bool bReplay = FParse::Value(FCommandLine::Get(), TEXT("WorkshopReplay="), replayPath);
+
+	// The copies of the other players on a client are never recorded.
+	if ((!bRecord && !bReplay) || character->Role == ROLE_SimulatedProxy) {
+		return nullptr;
+	}
+
+	ASessionRecorder* recorder = FindOrSpawnWorldManager<ASessionRecorder>(character->GetWorld());
+
+	if (recorder == nullptr) {
+		return nullptr;
+	}
+
+	// One character per log, the first one to begin play, the events of the other players are not recorded.
+	if (recorder->character != nullptr || recorder->mode != EMode::Idle) {
+		return recorder->character == character ? recorder : nullptr;
+	}
+
+	recorder->character = character;
+	recorder->path = FPaths::IsRelative(bReplay ? replayPath : recordPath)
+		? FPaths::Combine(FPaths::GameSavedDir(), bReplay ? replayPath : recordPath)
+		: (bReplay ? replayPath : recordPath);
+
+	if (bReplay) {
+		recorder->StartReplay();
+	}
+	else {
+		recorder->StartRecording();
+	}
+	return recorder;
+}
+
+bool ASessionRecorder::HandleEvent(const FSessionEvent& event)
+{
+	switch (mode)
+	{
+	case EMode::Recording:
+		pendingEvents.Add(event);
+		return true;
+
+	case EMode::Replaying:
+		return bApplyingEvent;
+
+	default:
+		return true;
+	}
+}
+
+uint32 ASessionRecorder::HashTransformables(UWorld* world)
+{
+	TArray<ATransformable*> transformables;
+	for (TActorIterator<ATransformable> it(world); it; ++it) {
+		transformables.Add(*it);
+	}
+
+	// Same order whatever the order of the actors in the level.
+	transformables.Sort([](const ATransformable& a, const ATransformable& b) { return a.GetName() < b.GetName(); });
+
+	// Replayed frames have the recorded delta times, the tweens end the recording at the same progress.
+	uint32 hash = 0;
+	for (const ATransformable* transformable : transformables)
+	{
+		for (int i = 0; i < Powers::Count; i++)
+		{
+			const FPowerValue& power = transformable->powers.GetPower(i);
+			const uint8 isModifying = power.isModifying ? 1 : 0;
+
+			hash = FCrc::MemCrc32(&power.newValue, sizeof(power.newValue), hash);
+			hash = FCrc::MemCrc32(&power.actualValue, sizeof(power.actualValue), hash);
+			hash = FCrc::MemCrc32(&isModifying, sizeof(isModifying), hash);
+		}
+
+		const uint32 mask = transformable->GetPowerMask();
+		hash = FCrc::MemCrc32(&mask, sizeof(mask), hash);
+
+		// Transform written to the actor, quantized to ignore the float noise of the physics: 0.1 cm, 0.1 degree, 0.001 scale.
+		const FTransform& transform = transformable->GetActorTransform();
+		const FVector euler = transform.Rotator().Euler();
+		const int32 quantized[] = {
+			FMath::RoundToInt(transform.GetLocation().X * 10.0f), FMath::RoundToInt(transform.GetLocation().Y * 10.0f), FMath::RoundToInt(transform.GetLocation().Z * 10.0f),
+			FMath::RoundToInt(euler.X * 10.0f), FMath::RoundToInt(euler.Y * 10.0f), FMath::RoundToInt(euler.Z * 10.0f),
+			FMath::RoundToInt(transform.GetScale3D().X * 1000.0f), FMath::RoundToInt(transform.GetScale3D().Y * 1000.0f), FMath::RoundToInt(transform.GetScale3D().Z * 1000.0f),
+		};
+		hash = FCrc::MemCrc32(quantized, sizeof(quantized), hash);
+	}
+	return hash;
+}
+
+// Called every frame
+void ASessionRecorder::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (mode == EMode::Recording) {
+		RecordFrame(DeltaTime);
+	}
+	else if (mode == EMode::Replaying) {
+		// Game thread time of the previous frame, the last replayed one.
+		if (replayFrame > 0) {
+			gameThreadMs.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+		}
+
+		if (replayFrame < frames.Num()) {
+			ReplayFrame();
+		}
+		else {
+			FinishReplay();
+		}
+	}
+}
+
+void ASessionRecorder::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (mode == EMode::Recording) {
+		StopRecording();
+	}
+	else if (mode == EMode::Replaying) {
+		UE_LOG(LogWorkshopUE, Warning, TEXT("Replay of %s interrupted at frame %d of %d"), *path, replayFrame, frames.Num());
+		FApp::SetUseFixedTimeStep(false);
+	}
+
+	mode = EMode::Idle;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASessionRecorder::StartRecording()
+{
+	mode = EMode::Recording;
+	frames.Reset();
+	pendingEvents.Reset();
+
+	// Record after the input and the movement, events of a frame are replayed with the pose of the previous frame.
+	SetTickGroup(TG_PostUpdateWork);
+	SetActorTickEnabled(true);
+
+	FSessionFrame start;
+	start.deltaTime = 0.0f;
+	start.location = character->GetActorLocation();
+	start.rotation = character->GetActorRotation();
+	start.controlRotation = character->GetControlRotation();
+	frames.Add(start);
+
+	UE_LOG(LogWorkshopUE, Display, TEXT("Recording session to %s"), *path);
+}
+
+void ASessionRecorder::RecordFrame(float DeltaTime)
+{
+	// The last frame holds the pose at the start of this frame.
+	FSessionFrame& frame = frames.Last();
+	frame.deltaTime = DeltaTime;
+	frame.events = MoveTemp(pendingEvents);
+	pendingEvents.Reset();
+
+	FSessionFrame next;
+	next.deltaTime = 0.0f;
+	next.location = character->GetActorLocation();
+	next.rotation = character->GetActorRotation();
+	next.controlRotation = character->GetControlRotation();
+	frames.Add(next);
+}
+
+void ASessionRecorder::StopRecording()
+{
+	// Drop the frame in progress, its delta time is not known.
+	frames.Pop(false);
+	recordedHash = HashTransformables(GetWorld());
+
+	TArray<uint8> data;
+	FMemoryWriter writer(data);
+
+	uint32 magic = SessionMagic;
+	int32 version = SessionVersion;
+	FString mapName = GetWorld()->GetMapName();
+	writer << magic << version << mapName << frames << recordedHash;
+
+	if (FFileHelper::SaveArrayToFile(data, *path)) {
+		UE_LOG(LogWorkshopUE, Display, TEXT("Recorded %d frames to %s (%d bytes)"), frames.Num(), *path, data.Num());
+	}
+	else {
+		UE_LOG(LogWorkshopUE, Error, TEXT("Failed to write session %s"), *path);
+	}
+
+	mode = EMode::Idle;
+	SetActorTickEnabled(false);
+}
+
+bool ASessionRecorder::StartReplay()
+{
+	TArray<uint8> data;
+	if (!FFileHelper::LoadFileToArray(data, *path)) {
+		UE_LOG(LogWorkshopUE, Error, TEXT("Failed to read session %s"), *path);
+		return false;
+	}
+
+	FMemoryReader reader(data);
+
+	uint32 magic = 0;
+	int32 version = 0;
+	FString mapName;
+	reader << magic << version;
+
+	if (magic != SessionMagic || version != SessionVersion) {
+		UE_LOG(LogWorkshopUE, Error, TEXT("%s is not a session log of version %d"), *path, SessionVersion);
+		return false;
+	}
+
+	reader << mapName << frames << recordedHash;
+
+	if (reader.IsError() || frames.Num() == 0) {
+		UE_LOG(LogWorkshopUE, Error, TEXT("Session %s is corrupted or empty"), *path);
+		return false;
+	}
+
+	if (mapName != GetWorld()->GetMapName()) {
+		UE_LOG(LogWorkshopUE, Warning, TEXT("Session %s was recorded on %s, replaying on %s"), *path, *mapName, *GetWorld()->GetMapName());
+	}
+
+	mode = EMode::Replaying;
+	replayFrame = 0;
+	gameThreadMs.Reset(frames.Num());
+	eventsMs.Reset(frames.Num());
+
+	// The log drives the character, its movement and its input are ignored.
+	character->GetCharacterMovement()->DisableMovement();
+
+	// Replay before the movement and the gameplay of the frame.
+	SetTickGroup(TG_PrePhysics);
+	SetActorTickEnabled(true);
+
+	// Recorded delta times are used as fixed time steps, the next frame is the first one replayed.
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(frames[0].deltaTime);
+
+	UE_LOG(LogWorkshopUE, Display, TEXT("Replaying %d frames from %s"), frames.Num(), *path);
+	return true;
+}
+
+void ASessionRecorder::ReplayFrame()
+{
+	const FSessionFrame& frame = frames[replayFrame];
+
+	character->SetActorLocationAndRotation(frame.location, frame.rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	if (character->GetController() != nullptr) {
+		character->GetController()->SetControlRotation(frame.controlRotation);
+	}
+
+	const uint32 startCycles = FPlatformTime::Cycles();
+
+	bApplyingEvent = true;
+	for (const FSessionEvent& event : frame.events) {
+		ApplyEvent(event);
+	}
+	bApplyingEvent = false;
+
+	eventsMs.Add(FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - startCycles));
+
+	replayFrame++;
+	if (replayFrame < frames.Num()) {
+		FApp::SetFixedDeltaTime(frames[replayFrame].deltaTime);
+	}
+}
+
+void ASessionRecorder::ApplyEvent(const FSessionEvent& event)
+{
+	switch (event.type)
+	{
+	case ESessionEvent::Fire: character->OnFire(); break;
+	case ESessionEvent::Absorb: character->OnAbsorb(); break;
+	case ESessionEvent::SwitchPower: character->SelectPower(event.index); break;
+	case ESessionEvent::ChangePower: character->ChangePower(event.index); break;
+	case ESessionEvent::EquipGun: character->EquipGun(); break;
+	case ESessionEvent::UnlockPower: character->UnlockNewPower(event.index); break;
+	case ESessionEvent::Checkpoint: character->SetNewCheckpoint(event.location); break;
+	case ESessionEvent::Teleport: character->TeleportToLastCheckpoint(); break;
+	case ESessionEvent::Kill: character->KillPlayer(); break;
+	case ESessionEvent::PassBarrier: character->PassThroughBarrer(); break;
+	case ESessionEvent::ExitBarrier: character->ExitBarrer(); break;
+	default: break;
+	}
+}
+
+void ASessionRecorder::FinishReplay()
+{
+	mode = EMode::Idle;
+	SetActorTickEnabled(false);
+	FApp::SetUseFixedTimeStep(false);
+
+	const uint32 hash = HashTransformables(GetWorld());
+
+	if (hash == recordedHash) {
+		UE_LOG(LogWorkshopUE, Display, TEXT("Replay of %s: transformables match the recording (%08x)"), *path, hash);
+	}
+	else {
+		UE_LOG(LogWorkshopUE, Error, TEXT("Replay of %s: transformables differ from the recording (%08x, recorded %08x)"), *path, hash, recordedHash);
+	}
+
+	TArray<float> sorted = gameThreadMs;
+	sorted.Sort();
+
+	if (sorted.Num() > 0) {
+		float total = 0.0f;
+		for (float ms : sorted) {
+			total += ms;
+		}
+
+		UE_LOG(LogWorkshopUE, Display, TEXT("Replay of %s: %d frames, game thread avg %.3f ms, p95 %.3f ms, max %.3f ms"),
+			*path, sorted.Num(), total / sorted.Num(), sorted[(sorted.Num() - 1) * 95 / 100], sorted.Last());
+	}
+
+	WriteTimings();
+
+	// Replays run unattended, quit when done.
+	FPlatformMisc::RequestExit(false);
+}
+
+void ASessionRecorder::WriteTimings() const
+{
+	FString csv = TEXT("frame,deltaTime,gameThreadMs,eventsMs,events\n");
+
+	for (int i = 0; i < gameThreadMs.Num() && i < eventsMs.Num(); i++)
+	{
+		csv += FString::Printf(TEXT("%d,%.6f,%.4f,%.4f,%d\n"), i, frames[i].deltaTime, gameThreadMs[i], eventsMs[i], frames[i].events.Num());
+	}
+
+	const FString csvPath = FPaths::Combine(FPaths::GameSavedDir(), TEXT("Profiling"), FPaths::GetBaseFilename(path) + TEXT("-replay.csv"));
+
+	if (FFileHelper::SaveStringToFile(csv, *csvPath)) {
+		UE_LOG(LogWorkshopUE, Display, TEXT("Replay timings written to %s"), *csvPath);
+	}
+}
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SessionRecorder.generated.h"
+
+class AWorkshopUECharacter;
+
+/* Gameplay event stored in a session log. */
+enum class ESessionEvent : uint8
+{
+	Fire,
+	Absorb,
+	SwitchPower,	// index: power
+	ChangePower,	// index: -1 previous, 1 next
+	EquipGun,
+	UnlockPower,	// index: power
+	Checkpoint,		// location: checkpoint
+	Teleport,
+	Kill,
+	PassBarrier,
+	ExitBarrier
+};
+
+struct FSessionEvent
+{
+	ESessionEvent type;
+	int8 index;
+	FVector location;
+
+	friend FArchive& operator<<(FArchive& Ar, FSessionEvent& event);
+};
+
+/* One game frame of a session log, the pose is the one used by the events of the frame. */
+struct FSessionFrame
+{
+	float deltaTime;
+	FVector location;
+	FRotator rotation;
+	FRotator controlRotation;
+	TArray<FSessionEvent> events;
+
+	friend FArchive& operator<<(FArchive& Ar, FSessionFrame& frame);
+};
+
+/*
+ * Records the gameplay of a player in a binary log and replays it without a human player.
+ *
+ * Recording stores for each frame the delta time, the pose of the character and its gameplay events.
+ * A replay uses the recorded delta times as fixed time steps, teleports the character to the recorded poses
+ * and calls the recorded events, live events being dropped. At the end, the state of the transformables
+ * is compared with the recording and the game thread time of each frame is written to a CSV file.
+ *
+ * Started from the command line, e.g. for a headless regression run:
+ *	WorkshopUE <map> -nullrhi -unattended -WorkshopReplay=Sessions/run.wsr
+ * -WorkshopRecord=<file> records the session, saved when the world ends.
+ * Relative paths are in the Saved directory of the project.
+ */
+UCLASS(NotPlaceable, Transient)
+class WORKSHOPUE_API ASessionRecorder : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASessionRecorder();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	/*
+	 * Start the recording or the replay asked on the command line for a player, null if none is asked.
+	 * Only the first player attached is recorded, null for the others.
+	 */
+	static ASessionRecorder* AttachFromCommandLine(AWorkshopUECharacter* character);
+
+	/*
+	 * Called by the character for each gameplay event.
+	 * Return false if the event must be dropped, replays only accept the events of the log.
+	 */
+	bool HandleEvent(const FSessionEvent& event);
+
+	/* Hash of the power state and of the transform of every transformable of the world. */
+	static uint32 HashTransformables(UWorld* world);
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	enum class EMode : uint8
+	{
+		Idle,
+		Recording,
+		Replaying
+	};
+
+	EMode mode;
+
+	UPROPERTY()
+	AWorkshopUECharacter* character;
+
+	FString path;
+
+	/* Recorded frames, or frames to replay. */
+	TArray<FSessionFrame> frames;
+
+	/* Events of the frame being recorded. */
+	TArray<FSessionEvent> pendingEvents;
+
+	/* Next frame to replay. */
+	int replayFrame;
+
+	/* True while the replay calls an event of the log. */
+	bool bApplyingEvent;
+
+	/* Transformables hash at the end of the recording. */
+	uint32 recordedHash;
+
+	// Replay timings, one entry per replayed frame.
+	TArray<float> gameThreadMs;
+	TArray<float> eventsMs;
+
+	void StartRecording();
+	void StopRecording();
+
+	bool StartReplay();
+	void ReplayFrame();
+	void FinishReplay();
+
+	void RecordFrame(float DeltaTime);
+	void ApplyEvent(const FSessionEvent& event);
+
+	void WriteTimings() const;
+};
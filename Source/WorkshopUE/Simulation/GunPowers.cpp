@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GunPowers.h"
+
+FGunPowers::FGunPowers()
+{
+	states.unlockedMask = 0;
+	states.availableMask = 0;
+
+	for (FSimVector& value : states.values) {
+		value = { 0.0f, 0.0f, 0.0f };
+	}
+
+	currentPower = -1;
+	bEquipped = false;
+	changedPowers = 0;
+}
+
+void FGunPowers::Equip()
+{
+	bEquipped = true;
+
+	Unlock(0);
+	currentPower = 0;
+}
+
+bool FGunPowers::SwitchTo(int index)
+{
+	if (!Powers::IsValid(index) || !bEquipped) {
+		return false;
+	}
+
+	// Check if power is unlocked and power is not already selected.
+	if (!states.IsUnlocked(index) || currentPower == index) {
+		return false;
+	}
+
+	currentPower = index;
+	return true;
+}
+
+void FGunPowers::Unlock(int index)
+{
+	if (!Powers::IsValid(index)) {
+		return;
+	}
+
+	states.unlockedMask |= 1u << index;
+	states.availableMask &= ~(1u << index);
+
+	MarkChanged(index);
+}
+
+bool FGunPowers::TryToUse()
+{
+	if (currentPower == -1 || !states.IsAvailable(currentPower)) {
+		return false;
+	}
+
+	MarkChanged(currentPower);
+
+	states.availableMask &= ~(1u << currentPower);
+
+	return true;
+}
+
+void FGunPowers::SetAvailable(int index)
+{
+	if (!Powers::IsValid(index)) {
+		return;
+	}
+
+	states.availableMask |= 1u << index;
+
+	MarkChanged(index);
+}
+
+void FGunPowers::Absorb()
+{
+	if (currentPower == -1) {
+		return;
+	}
+
+	SetAvailable(currentPower);
+}
+
+void FGunPowers::Reset()
+{
+	states.availableMask = 0;
+
+	// Unlocked powers are displayed as unavailable.
+	changedPowers |= states.unlockedMask;
+
+	for (FSimVector& value : states.values) {
+		value = { 0.0f, 0.0f, 0.0f };
+	}
+}
+
+uint32_t FGunPowers::ConsumeChanges()
+{
+	const uint32_t changed = changedPowers;
+	changedPowers = 0;
+	return changed;
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "PowerRules.h"
+
+/* Powers of the gun, one bit per power index in the masks. */
+struct FPowerStates
+{
+	uint32_t unlockedMask;
+	uint32_t availableMask;
+
+	/* Value of each power held by the gun, packed as described in PowerRules.h. */
+	FSimVector values[Powers::Count];
+
+	bool IsUnlocked(int index) const { return (unlockedMask & (1u << index)) != 0; }
+	bool IsAvailable(int index) const { return (availableMask & (1u << index)) != 0; }
+};
+
+/*
+ * Power state machine of the gun: unlocked and available powers, selected power and power values.
+ * Every change is recorded in a change mask, consumed by the owner to notify the listeners.
+ */
+class FGunPowers
+{
+public:
+	FGunPowers();
+
+	const FPowerStates& GetStates() const { return states; }
+	FPowerStates& GetStates() { return states; }
+
+	/* Selected power, -1 if none. */
+	int GetCurrentPower() const { return currentPower; }
+
+	bool IsEquipped() const { return bEquipped; }
+	void SetEquipped(bool bInEquipped) { bEquipped = bInEquipped; }
+
+	/* Equipped with a selected power. */
+	bool IsEnabled() const { return bEquipped && currentPower != -1; }
+
+	/* Equip the gun, unlock the first power and select it. */
+	void Equip();
+
+	/* Select an unlocked power, return true if the selection changed. */
+	bool SwitchTo(int index);
+
+	/* Unlocked power after or before the selected one, -1 if none is unlocked. */
+	int GetNextPower() const { return Powers::NextInMask(states.unlockedMask, currentPower); }
+	int GetPreviousPower() const { return Powers::PreviousInMask(states.unlockedMask, currentPower); }
+
+	/* Unlock a power, it is not available until absorbed. */
+	void Unlock(int index);
+
+	/* Use the selected power if available, return false otherwise. */
+	bool TryToUse();
+
+	void SetAvailable(int index);
+
+	/* Make the selected power available again. */
+	void Absorb();
+
+	/* Make every power unavailable and clear the values, unlocked powers stay unlocked. */
+	void Reset();
+
+	void MarkChanged(int index) { changedPowers |= 1u << index; }
+
+	/* Powers changed since the last call to ConsumeChanges. */
+	uint32_t GetChanges() const { return changedPowers; }
+
+	uint32_t ConsumeChanges();
+
+private:
+	FPowerStates states;
+	int currentPower;
+	bool bEquipped;
+	uint32_t changedPowers;
+};
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+ * Rules of the gun powers, shared by the game and the standalone simulation library.
+ * This directory only depends on the C++ standard library, see Simulation/CMakeLists.txt at the root of the project.
+ */
+
+/* Power value, laid out like FVector. */
+struct FSimVector
+{
+	float x, y, z;
+
+	FSimVector operator+(const FSimVector& other) const { return { x + other.x, y + other.y, z + other.z }; }
+	FSimVector operator-(const FSimVector& other) const { return { x - other.x, y - other.y, z - other.z }; }
+	FSimVector operator*(float scale) const { return { x * scale, y * scale, z * scale }; }
+	FSimVector& operator+=(const FSimVector& other) { x += other.x; y += other.y; z += other.z; return *this; }
+	bool operator==(const FSimVector& other) const { return x == other.x && y == other.y && z == other.z; }
+	bool operator!=(const FSimVector& other) const { return !(*this == other); }
+};
+
+/* Transform channel changed by a power. */
+enum class ETransformChannel : uint8_t
+{
+	Location,
+	Rotation,
+	Scale,
+	Count
+};
+
+struct FPowerColor
+{
+	float r, g, b;
+};
+
+/*
+ * Compile-time description of a gun power.
+ * Power values are packed in a vector, rotations as (roll, pitch, yaw) like FRotator::Euler().
+ */
+struct FPowerDescriptor
+{
+	/* Channel of the transformable changed by this power. */
+	ETransformChannel channel;
+
+	/* Value added by a transform effect. */
+	float effectX, effectY, effectZ;
+
+	/* Color of the power on the gun and on the transformables. */
+	FPowerColor color;
+
+	/* Yaw of the gun tubes when this power is selected. */
+	float tubeYaw;
+};
+
+namespace Powers
+{
+	constexpr FPowerDescriptor Table[] = {
+		{ ETransformChannel::Location, 300.0f, 0.0f, 0.0f, { 1.0f, 0.0f, 0.0f }, 60.0f },	// Translate
+		{ ETransformChannel::Rotation, 45.0f, 0.0f, 0.0f, { 0.0f, 1.0f, 0.0f }, -60.0f },	// Rotate (roll)
+		{ ETransformChannel::Scale, 1.0f, 1.0f, 1.0f, { 0.0f, 0.0f, 1.0f }, -180.0f },		// Scale
+	};
+
+	constexpr int Count = sizeof(Table) / sizeof(Table[0]);
+	constexpr uint32_t AllMask = (1u << Count) - 1;
+
+	static_assert(Count <= 32, "Power masks are stored on 32 bits.");
+
+	/*
+	 * Color of a transformable with a combination of powers: the sum of the colors of the powers,
+	 * scaled so its brightest channel is 1. A power alone has its own color, no power is black.
+	 */
+	constexpr FPowerColor GetMaskColor(uint32_t mask)
+	{
+		FPowerColor sum = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < Count; i++) {
+			if ((mask & (1u << i)) != 0) {
+				sum.r += Table[i].color.r;
+				sum.g += Table[i].color.g;
+				sum.b += Table[i].color.b;
+			}
+		}
+
+		const float brightest = sum.r > sum.g ? (sum.r > sum.b ? sum.r : sum.b) : (sum.g > sum.b ? sum.g : sum.b);
+		if (brightest <= 0.0f) {
+			return sum;
+		}
+		return { sum.r / brightest, sum.g / brightest, sum.b / brightest };
+	}
+
+	/* Tolerance of the power value comparisons, KINDA_SMALL_NUMBER in the engine. */
+	constexpr float Tolerance = 1.e-4f;
+
+	inline bool IsValid(int index)
+	{
+		return index >= 0 && index < Count;
+	}
+
+	inline FSimVector GetEffect(int index)
+	{
+		return { Table[index].effectX, Table[index].effectY, Table[index].effectZ };
+	}
+
+	/* Angle in degrees in ]-180, 180], like FRotator::NormalizeAxis. */
+	inline float NormalizeAxis(float angle)
+	{
+		angle = std::fmod(angle, 360.0f);
+		if (angle < 0.0f) {
+			angle += 360.0f;
+		}
+		return angle > 180.0f ? angle - 360.0f : angle;
+	}
+
+	/* Check if a power value has no effect, rotations are compared as angles. */
+	inline bool IsZero(int index, const FSimVector& value)
+	{
+		if (Table[index].channel == ETransformChannel::Rotation) {
+			return std::fabs(NormalizeAxis(value.x)) <= Tolerance && std::fabs(NormalizeAxis(value.y)) <= Tolerance
+				&& std::fabs(NormalizeAxis(value.z)) <= Tolerance;
+		}
+		return std::fabs(value.x) <= Tolerance && std::fabs(value.y) <= Tolerance && std::fabs(value.z) <= Tolerance;
+	}
+
+	/* Index of the lowest set bit, mask must not be 0. */
+	inline int LowestBit(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (int)index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	/* Index of the highest set bit, mask must not be 0. */
+	inline int HighestBit(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, mask);
+		return (int)index;
+#else
+		return 31 - __builtin_clz(mask);
+#endif
+	}
+
+	/* First power of the mask after index, wrapping around. -1 if the mask is empty. */
+	inline int NextInMask(uint32_t mask, int index)
+	{
+		if (mask == 0) {
+			return -1;
+		}
+
+		// Powers after index, or the first one of the mask when wrapping around.
+		const uint32_t after = index < 0 ? mask : mask & ~((2u << index) - 1u);
+		return LowestBit(after != 0 ? after : mask);
+	}
+
+	/* Last power of the mask before index, wrapping around. -1 if the mask is empty. */
+	inline int PreviousInMask(uint32_t mask, int index)
+	{
+		if (mask == 0) {
+			return -1;
+		}
+
+		// Powers before index, or the last one of the mask when wrapping around.
+		const uint32_t before = index <= 0 ? 0u : mask & ((1u << index) - 1u);
+		return HighestBit(before != 0 ? before : mask);
+	}
+}
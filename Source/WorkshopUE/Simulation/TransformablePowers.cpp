@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TransformablePowers.h"
+#include "GunPowers.h"
+
+#include <utility>
+
+FTransformablePowers::FTransformablePowers()
+{
+	for (FPowerValue& power : powers) {
+		power.isModifying = false;
+		power.oldValue = power.actualValue = power.newValue = { 0.0f, 0.0f, 0.0f };
+	}
+	powerMask = 0;
+}
+
+uint32_t FTransformablePowers::Setup(const FSimVector initialValues[Powers::Count])
+{
+	powerMask = 0;
+
+	for (int i = 0; i < Powers::Count; i++)
+	{
+		FPowerValue& power = powers[i];
+		power.oldValue = power.actualValue = power.newValue = initialValues[i];
+		power.isModifying = !Powers::IsZero(i, power.newValue);
+
+		if (power.isModifying) {
+			powerMask |= 1u << i;
+		}
+	}
+
+	return powerMask;
+}
+
+void FTransformablePowers::StopAtOldValues()
+{
+	for (FPowerValue& power : powers) {
+		power.isModifying = false;
+		power.actualValue = power.oldValue;
+	}
+}
+
+void FTransformablePowers::TransformEffect(int index)
+{
+	FPowerValue& power = powers[index];
+
+	if (power.isModifying) {
+		power.oldValue = power.actualValue;
+	}
+	power.newValue += Powers::GetEffect(index);
+	power.isModifying = true;
+}
+
+void FTransformablePowers::PutPowerEffect(int index, FGunPowers& gun)
+{
+	FPowerValue& power = powers[index];
+
+	if (power.isModifying) {
+		power.oldValue = power.actualValue;
+	}
+
+	// The value held by the gun changed, even if its availability didn't.
+	std::swap(power.newValue, gun.GetStates().values[index]);
+	gun.MarkChanged(index);
+	power.isModifying = true;
+
+	const bool bWasPresent = HasPower(index);
+
+	if (Powers::IsZero(index, power.newValue)) {
+		powerMask &= ~(1u << index);
+	}
+	else {
+		powerMask |= 1u << index;
+
+		if (bWasPresent) {
+			gun.SetAvailable(index);
+		}
+	}
+}
+
+void FTransformablePowers::SetNewValue(int index, const FSimVector& value)
+{
+	FPowerValue& power = powers[index];
+
+	if (power.isModifying) {
+		power.oldValue = power.actualValue;
+	}
+	power.newValue = value;
+	power.isModifying = true;
+
+	if (Powers::IsZero(index, value)) {
+		powerMask &= ~(1u << index);
+	}
+	else {
+		powerMask |= 1u << index;
+	}
+}
+
+void FTransformablePowers::ApplyTweenValue(int index, const FSimVector& value, bool bFinished)
+{
+	FPowerValue& power = powers[index];
+	power.actualValue = value;
+
+	if (bFinished) {
+		power.isModifying = false;
+		power.oldValue = power.newValue;
+	}
+}
+
+FSimVector FTransformablePowers::GetChannelOffset(ETransformChannel channel) const
+{
+	FSimVector offset = { 0.0f, 0.0f, 0.0f };
+
+	for (int i = 0; i < Powers::Count; i++) {
+		if (Powers::Table[i].channel == channel) {
+			offset += powers[i].actualValue;
+		}
+	}
+	return offset;
+}
+
+void FTransformablePowers::CaptureSnapshot(FTransformableSnapshot& snapshot) const
+{
+	for (int i = 0; i < Powers::Count; i++) {
+		snapshot.values[i] = powers[i].newValue;
+	}
+	snapshot.powerMask = powerMask;
+}
+
+void FTransformablePowers::RestoreSnapshot(const FTransformableSnapshot& snapshot)
+{
+	for (int i = 0; i < Powers::Count; i++) {
+		FPowerValue& power = powers[i];
+		power.isModifying = false;
+		power.oldValue = power.actualValue = power.newValue = snapshot.values[i];
+	}
+	powerMask = snapshot.powerMask;
+}
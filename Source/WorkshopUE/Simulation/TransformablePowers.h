@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "PowerRules.h"
+
+class FGunPowers;
+
+/* State of a power on a transformable, values are packed as described in PowerRules.h. */
+struct FPowerValue
+{
+	bool isModifying;
+	FSimVector oldValue;
+	FSimVector actualValue;
+	FSimVector newValue;
+};
+
+/* Power state of a transformable at rest, as recorded in a snapshot. */
+struct FTransformableSnapshot
+{
+	FSimVector values[Powers::Count];
+	uint32_t powerMask;
+};
+
+/*
+ * Powers of a transformable. A power moves from its old value to its new value through a tween
+ * driven by the owner, which reports the interpolated values with ApplyTweenValue.
+ */
+class FTransformablePowers
+{
+public:
+	FTransformablePowers();
+
+	const FPowerValue& GetPower(int index) const { return powers[index]; }
+
+	/* Powers present, one bit per power index. */
+	uint32_t GetMask() const { return powerMask; }
+
+	bool HasPower(int index) const { return Powers::IsValid(index) && (powerMask & (1u << index)) != 0; }
+
+	/* Set each power to its initial value, return the mask of the powers having an effect, to tween. */
+	uint32_t Setup(const FSimVector initialValues[Powers::Count]);
+
+	/* Stop every power at its old value. */
+	void StopAtOldValues();
+
+	/* Add the effect of a power to its new value, to tween. */
+	void TransformEffect(int index);
+
+	/*
+	 * Swap the new value of a power with the value held by the gun, to tween.
+	 * If the power was already present and stays present, it is given back to the gun.
+	 */
+	void PutPowerEffect(int index, FGunPowers& gun);
+
+	/* Set the new value of a power decided elsewhere, e.g. by a server, to tween. */
+	void SetNewValue(int index, const FSimVector& value);
+
+	/* Interpolated value of a power tween, the power is at rest once finished. */
+	void ApplyTweenValue(int index, const FSimVector& value, bool bFinished);
+
+	/* Sum of the actual values of the powers of a channel. */
+	FSimVector GetChannelOffset(ETransformChannel channel) const;
+
+	/* Record the state at rest of the powers, tweens in progress are recorded at their end. */
+	void CaptureSnapshot(FTransformableSnapshot& snapshot) const;
+
+	/* Set the powers back to a recorded state, at rest. */
+	void RestoreSnapshot(const FTransformableSnapshot& snapshot);
+
+private:
+	FPowerValue powers[Powers::Count];
+	uint32_t powerMask;
+};
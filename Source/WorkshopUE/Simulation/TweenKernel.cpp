@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TweenKernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WORKSHOP_TWEEN_SSE 1
+#include <emmintrin.h>
+#else
+#define WORKSHOP_TWEEN_SSE 0
+#endif
+
+void TweenKernel::ComputeAlphas(int count, double time, const double* startTime, const float* invDuration, float* alpha)
+{
+	int i = 0;
+
+#if WORKSHOP_TWEEN_SSE
+	const __m128d now = _mm_set1_pd(time);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	// Four tweens per iteration, the elapsed times are computed in double then narrowed.
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 low = _mm_cvtpd_ps(_mm_sub_pd(now, _mm_loadu_pd(startTime + i)));
+		const __m128 high = _mm_cvtpd_ps(_mm_sub_pd(now, _mm_loadu_pd(startTime + i + 2)));
+
+		const __m128 ratio = _mm_mul_ps(_mm_movelh_ps(low, high), _mm_loadu_ps(invDuration + i));
+		_mm_storeu_ps(alpha + i, _mm_min_ps(_mm_max_ps(ratio, zero), one));
+	}
+#endif
+
+	// Remaining tweens.
+	for (; i < count; i++)
+	{
+		alpha[i] = ComputeAlpha(time, startTime[i], invDuration[i]);
+	}
+}
+
+void TweenKernel::Interpolate(int count, const float* alpha, const FTweenVector* from, const FTweenVector* to, FTweenVector* value)
+{
+	for (int i = 0; i < count; i++)
+	{
+#if WORKSHOP_TWEEN_SSE
+		const __m128 start = _mm_load_ps(&from[i].x);
+		const __m128 delta = _mm_sub_ps(_mm_load_ps(&to[i].x), start);
+		_mm_store_ps(&value[i].x, _mm_add_ps(_mm_mul_ps(delta, _mm_set1_ps(alpha[i])), start));
+#else
+		value[i].x = from[i].x + (to[i].x - from[i].x) * alpha[i];
+		value[i].y = from[i].y + (to[i].y - from[i].y) * alpha[i];
+		value[i].z = from[i].z + (to[i].z - from[i].z) * alpha[i];
+		value[i].w = 0.0f;
+#endif
+	}
+}
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "PowerRules.h"
+
+#include <algorithm>
+
+/* Tween value padded to 16 bytes, the same layout as a VectorRegister. */
+struct alignas(16) FTweenVector
+{
+	float x, y, z, w;
+
+	static FTweenVector FromSim(const FSimVector& value) { return { value.x, value.y, value.z, 0.0f }; }
+	FSimVector ToSim() const { return { x, y, z }; }
+};
+
+/*
+ * Batched interpolation of the transformable tweens.
+ * Tweens are stored as contiguous arrays, a channel value (location, rotation or scale)
+ * is packed in a FTweenVector so every channel shares the same kernel.
+ * A tween is stored as its start time, its duration and its end points, so it can be evaluated
+ * at any time without being updated every frame, and gives the same value whatever the frame rate.
+ * Uses SSE when available, scalar code otherwise.
+ */
+namespace TweenKernel
+{
+	/* Alpha of a tween at a time, clamped to [0, 1]. */
+	inline float ComputeAlpha(double time, double startTime, float invDuration)
+	{
+		return std::min(std::max((float)(time - startTime) * invDuration, 0.0f), 1.0f);
+	}
+
+	/* Write the alpha of count tweens at a time, 1 once finished. */
+	void ComputeAlphas(int count, double time, const double* startTime, const float* invDuration, float* alpha);
+
+	/* Interpolate count tweens between from and to with the alphas computed by ComputeAlphas. */
+	void Interpolate(int count, const float* alpha, const FTweenVector* from, const FTweenVector* to, FTweenVector* value);
+}
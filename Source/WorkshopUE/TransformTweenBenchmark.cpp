@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorkshopUE.h"
+#include "Simulation/TweenKernel.h"
+#include "HAL/IConsoleManager.h"
+
+/*
+ * Microbenchmark of the tween interpolation, run with "WorkshopUE.BenchTweens [frames]".
+ * Compares the per-actor scalar path (one FMath::Lerp per actor and per channel, as ATransformable
+ * used to do in its Tick) with TweenKernel. Component updates are not included.
+ */
+namespace
+{
+	/* Tween state as stored by each actor in the per-actor path. */
+	struct FScalarTween
+	{
+		bool isModifying;
+		float timer;
+		FVector oldValue;
+		FVector actualValue;
+		FVector newValue;
+	};
+
+	double RunScalar(int count, int frames, float deltaTime, float timeToChange)
+	{
+		TArray<FScalarTween> tweens;
+		tweens.SetNumUninitialized(count);
+		for (int i = 0; i < count; i++) {
+			tweens[i] = { true, 0.0f, FVector::ZeroVector, FVector::ZeroVector, FVector(i, 1.0f, 2.0f) };
+		}
+
+		const double start = FPlatformTime::Seconds();
+
+		for (int frame = 0; frame < frames; frame++)
+		{
+			for (FScalarTween& tween : tweens)
+			{
+				if (tween.isModifying) {
+					tween.timer += deltaTime;
+					const float alpha = FMath::Min(tween.timer / timeToChange, 1.0f);
+					tween.actualValue = FMath::Lerp(tween.oldValue, tween.newValue, alpha);
+				}
+			}
+		}
+
+		return FPlatformTime::Seconds() - start;
+	}
+
+	double RunBatched(int count, int frames, float deltaTime, float timeToChange)
+	{
+		TArray<double> startTime;
+		TArray<float> invDuration, alpha;
+		startTime.Init(0.0, count);
+		invDuration.Init(1.0f / timeToChange, count);
+		alpha.Init(0.0f, count);
+
+		TArray<FTweenVector, TAlignedHeapAllocator<16>> from, to, value;
+		from.Init({ 0.0f, 0.0f, 0.0f, 0.0f }, count);
+		to.SetNumUninitialized(count);
+		value.SetNumUninitialized(count);
+		for (int i = 0; i < count; i++) {
+			to[i] = { (float)i, 1.0f, 2.0f, 0.0f };
+		}
+
+		const double start = FPlatformTime::Seconds();
+
+		for (int frame = 0; frame < frames; frame++)
+		{
+			TweenKernel::ComputeAlphas(count, (frame + 1) * (double)deltaTime, startTime.GetData(), invDuration.GetData(), alpha.GetData());
+			TweenKernel::Interpolate(count, alpha.GetData(), from.GetData(), to.GetData(), value.GetData());
+		}
+
+		return FPlatformTime::Seconds() - start;
+	}
+
+	void BenchTweens(const TArray<FString>& args)
+	{
+		const int frames = args.Num() > 0 ? FCString::Atoi(*args[0]) : 100;
+		const float deltaTime = 1.0f / 60.0f;
+
+		// Tweens long enough to stay active for the whole run.
+		const float timeToChange = frames * deltaTime + 1.0f;
+
+		for (int count : { 1000, 10000, 100000 })
+		{
+			const double scalar = RunScalar(count, frames, deltaTime, timeToChange);
+			const double batched = RunBatched(count, frames, deltaTime, timeToChange);
+
+			UE_LOG(LogWorkshopUE, Display, TEXT("BenchTweens %6d tweens: per-actor %.3f ms/frame, batched %.3f ms/frame (x%.2f)"),
+				count, scalar * 1000.0 / frames, batched * 1000.0 / frames, scalar / FMath::Max(batched, SMALL_NUMBER));
+		}
+	}
+
+	FAutoConsoleCommand BenchTweensCommand(
+		TEXT("WorkshopUE.BenchTweens"),
+		TEXT("Compare per-actor and batched tween interpolation at 1k, 10k and 100k tweens. Optional argument: frames."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchTweens));
+}
@@ -1,21 +1,43 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Transformable.h"
+#include "WorkshopUEStats.h"
+#include "GameFramework/GameStateBase.h"
+#include "UnrealNetwork.h"
+#include "NetRegionVolume.h"
 
 // Sets default values
 ATransformable::ATransformable()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Tweens are updated by the transformable manager, idle transformables never tick.
+	PrimaryActorTick.bCanEverTick = false;
+
+	manager = nullptr;
+	for (int& index : tweenIndices) {
+		index = INDEX_NONE;
+	}
+	gridIndex = INDEX_NONE;
+	// Only the power events are replicated, clients tween the transforms themselves.
+	// Transformables stay dormant, each event is flushed once, so idle ones cost nothing to the server.
+	bReplicates = true;
+	bReplicateMovement = false;
+	NetDormancy = DORM_Initial;
+	powerEvents.SetNum(Powers::Count);
+	netRegion = nullptr;
+	bPredicted = false;
+	bPowerEventsPending = false;
+
+	bTransformPending = false;
+	bCollisionStale = false;
+	collisionCommitTime = 0.0;
 
 	timeToChange = 1;
-	timerLoc = 0.0;
-	timerRot = 0.0;
-	timerScale = 0.0;
 
-	isModifyingLoc = false;
-	isModifyingRot = false;
-	isModifyingScale = false;
+	powerMaterial = nullptr;
+	colorParameterName = TEXT("Color");
+	materialIndex = 0;
+	colorMesh = nullptr;
+	colorMask = MAX_uint32;
 
 	initialLocation = FVector::ZeroVector;
 	initialRotation = FRotator::ZeroRotator;
@@ -28,268 +50,487 @@ void ATransformable::BeginPlay()
 	Super::BeginPlay();
 
 	root = GetRootComponent();
+	manager = ATransformableManager::Get(GetWorld());
+
+	if (powerMaterial != nullptr) {
+		colorMesh = FindComponentByClass<UMeshComponent>();
+	}
 
 	baseLocation = root->RelativeLocation;
 	baseRotation = root->RelativeRotation;
 	baseScale = root->RelativeScale3D;
 
 	Setup();
+
+	if (manager != nullptr) {
+		manager->Register(this);
+	}
+
+	// Events received before BeginPlay, by spawned transformables and late joiners, replace the local setup.
+	if (bPowerEventsPending) {
+		bPowerEventsPending = false;
+		OnRep_PowerEvents(TArray<FTransformablePowerEvent>());
+	}
+
+	if (HasAuthority()) {
+		netRegion = ANetRegionVolume::Find(GetWorld(), GetActorLocation());
+
+		// Placed transformables are known to the clients, spawned ones are sent once.
+		if (!IsNetStartupActor()) {
+			SetNetDormancy(DORM_DormantAll);
+		}
+	}
+}
+
+void ATransformable::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (manager != nullptr) {
+		manager->Unregister(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+FVector ATransformable::GetInitialValue(int powerIndex) const
+{
+	const ETransformChannel channel = Powers::Table[powerIndex].channel;
+
+	// Only the first power of a channel has an initial value.
+	for (int i = 0; i < powerIndex; i++) {
+		if (Powers::Table[i].channel == channel) {
+			return FVector::ZeroVector;
+		}
+	}
+
+	switch (channel)
+	{
+	case ETransformChannel::Location: return initialLocation;
+	case ETransformChannel::Rotation: return initialRotation.Euler();
+	case ETransformChannel::Scale: return initialScale;
+	default: return FVector::ZeroVector;
+	}
 }
 
 void ATransformable::Setup() {
-	// Setup transformation vectors
-	oldLocation = std::make_shared<FVector>(initialLocation);
-	actualLocation = std::make_shared<FVector>(initialLocation);
-	newLocation = std::make_shared<FVector>(initialLocation);
+	FSimVector initialValues[Powers::Count];
 
-	oldRotation = std::make_shared<FRotator>(initialRotation);
-	actualRotation = std::make_shared<FRotator>(initialRotation);
-	newRotation = std::make_shared<FRotator>(initialRotation);
+	for (int i = 0; i < Powers::Count; i++) {
+		initialValues[i] = Powers::ToSimVector(GetInitialValue(i));
+	}
 
-	oldScale = std::make_shared<FVector>(initialScale);
-	actualScale = std::make_shared<FVector>(initialScale);
-	newScale = std::make_shared<FVector>(initialScale);
+	// Tween the powers having an initial effect.
+	uint32 tweened = powers.Setup(initialValues);
 
-	// Setup transformable
-	bPower1 = isModifyingLoc = !newLocation->Equals(FVector::ZeroVector);
-	bPower2 = isModifyingRot = !newRotation->Equals(FRotator::ZeroRotator);
-	bPower3 = isModifyingScale = !newScale->Equals(FVector::ZeroVector);
+	while (tweened != 0)
+	{
+		StartTween((int)FMath::CountTrailingZeros(tweened));
+		tweened &= tweened - 1;
+	}
 
 	ChangeColor();
 }
 
-void ATransformable::Reset() {
-	Setup();
+void ATransformable::StartTween(int powerIndex) {
+	if (manager != nullptr) {
+		StartTween(powerIndex, manager->GetTweenTime());
+	}
+}
 
-	timerLoc = 0.0f;
-	timerRot = 0.0f;
-	timerScale = 0.0f;
-	isModifyingLoc = isModifyingRot = isModifyingScale = false;
-	ApplyLocationChange(0.0f);
-	ApplyRotationChange(0.0f);
-	ApplyScaleChange(0.0f);
+void ATransformable::StartTween(int powerIndex, double startTime) {
+	if (manager != nullptr) {
+		const FPowerValue& power = powers.GetPower(powerIndex);
+		manager->StartTween(this, powerIndex, power.oldValue, power.newValue, timeToChange, startTime);
+
+		// The tween clock of the server is the server time.
+		if (HasAuthority()) {
+			ReplicatePower(powerIndex, (float)startTime);
+		}
+	}
+}
+
+void ATransformable::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ATransformable, powerEvents);
 }
 
-// Called every frame
-void ATransformable::Tick(float DeltaTime)
+void ATransformable::ReplicatePower(int powerIndex, float startTime)
 {
-	Super::Tick(DeltaTime);
-
-	if (isModifyingLoc) {
-		timerLoc += DeltaTime;
-		if (timerLoc >= timeToChange || timeToChange == 0.0) {
-			ApplyLocationChange(1);
-			isModifyingLoc = false;
-			*oldLocation = *newLocation;
+	const FPowerValue& power = powers.GetPower(powerIndex);
+
+	FTransformablePowerEvent& event = powerEvents[powerIndex];
+	event.value = Powers::ToVector(startTime < 0.0f ? power.actualValue : power.newValue);
+	event.startTime = startTime;
+
+	// The initial tweens of BeginPlay are also played by the clients.
+	if (HasActorBegunPlay()) {
+		FlushNetDormancy();
+	}
+}
+
+bool ATransformable::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	if (netRegion != nullptr) {
+		const ANetRegionVolume* viewerRegion = manager != nullptr ? manager->GetViewerRegion(RealViewer, SrcLocation)
+			: ANetRegionVolume::Find(GetWorld(), SrcLocation);
+
+		if (viewerRegion != nullptr) {
+			return viewerRegion->Sees(netRegion);
 		}
-		else if (timeToChange > 0.0) {
-			float alpha = timerLoc / timeToChange;
-			ApplyLocationChange(alpha);
+	}
+
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
+
+void ATransformable::ReplicatePowersAtRest()
+{
+	if (HasAuthority()) {
+		for (int i = 0; i < Powers::Count; i++) {
+			ReplicatePower(i, -1.0f);
 		}
 	}
+}
 
-	if (isModifyingRot) {
-		timerRot += DeltaTime;
-		if (timerRot >= timeToChange || timeToChange == 0.0) {
-			ApplyRotationChange(1);
-			isModifyingRot = false;
-			*oldRotation = *newRotation;
+void ATransformable::OnRep_PowerEvents(const TArray<FTransformablePowerEvent>& previousEvents)
+{
+	// Applied in BeginPlay, once the manager is known.
+	if (manager == nullptr) {
+		bPowerEventsPending = true;
+		return;
+	}
+
+	// Offset from the server time to the tween clock of this client.
+	const AGameStateBase* gameState = GetWorld()->GetGameState();
+	const double now = manager->GetTweenTime();
+	const double serverToLocal = gameState != nullptr ? now - gameState->GetServerWorldTimeSeconds() : 0.0;
+
+	bool bChangedAtRest = false;
+
+	for (int i = 0; i < Powers::Count && i < powerEvents.Num(); i++)
+	{
+		const FTransformablePowerEvent& event = powerEvents[i];
+
+		if (previousEvents.IsValidIndex(i) && previousEvents[i] == event) {
+			continue;
 		}
-		else if (timeToChange > 0.0) {
-			float alpha = timerRot / timeToChange;
-			ApplyRotationChange(alpha);
+
+		const FSimVector value = Powers::ToSimVector(event.value);
+
+		// A confirmed prediction keeps its local tween.
+		if (bPredicted && Powers::ToVector(powers.GetPower(i).newValue).Equals(event.value, 0.01f)) {
+			continue;
 		}
-	}
 
-	if (isModifyingScale) {
-		timerScale += DeltaTime;
-		if (timerScale >= timeToChange || timeToChange == 0.0) {
-			ApplyScaleChange(1);
-			isModifyingScale = false;
-			*oldScale = *newScale;
+		// The new tween starts from the current value.
+		SyncTween(i);
+		powers.SetNewValue(i, value);
+
+		if (event.startTime >= 0.0f) {
+			StartTween(i, event.startTime + serverToLocal);
 		}
-		else if (timeToChange > 0.0) {
-			float alpha = timerScale / timeToChange;
-			ApplyScaleChange(alpha);
+		else {
+			manager->StopTween(this, i);
+			powers.ApplyTweenValue(i, value, true);
+			bChangedAtRest = true;
 		}
 	}
+
+	// Powers set at rest come from a reset or a restore of the server, a teleport.
+	if (bChangedAtRest) {
+		ApplyTransform(true);
+	}
+
+	// The server did something else than predicted.
+	if (bPredicted) {
+		Reconcile();
+	}
+
+	ChangeColor();
 }
 
-void ATransformable::TransformEffect(int powerIndex)
+void ATransformable::Reconcile()
 {
-	switch (powerIndex)
+	bPredicted = false;
+
+	for (int i = 0; i < Powers::Count && i < powerEvents.Num(); i++)
 	{
-		case 0:
-			if (isModifyingLoc) {
-				*oldLocation = *actualLocation;
-			}
-			*newLocation += FVector(300.0, 0.0, 0.0);
-			timerLoc = 0.0;
-			isModifyingLoc = true;
-			ChangeColor(FVector(1.0, 0.0, 0.0));
-			break;
-
-		case 1:
-			if (isModifyingRot) {
-				*oldRotation = *actualRotation;
-			}
-			*newRotation += FRotator(0.0, 0.0, 45.0);
-			timerRot = 0.0;
-			isModifyingRot = true;
-			ChangeColor(FVector(0.0, 1.0, 0.0));
-			break;
-
-		case 2:
-			if (isModifyingScale) {
-				*oldScale = *actualScale;
-			}
-			*newScale += FVector(1.0, 1.0, 1.0);
-			timerScale = 0.0;
-			isModifyingScale = true;
-			ChangeColor(FVector(0.0, 0.0, 1.0));
-			break;
-
-		default: break;
+		const FVector& serverValue = powerEvents[i].value;
+
+		if (Powers::ToVector(powers.GetPower(i).newValue).Equals(serverValue, 0.01f)) {
+			continue;
+		}
+
+		SyncTween(i);
+		powers.SetNewValue(i, Powers::ToSimVector(serverValue));
+		StartTween(i);
 	}
+
+	ChangeColor();
 }
 
-void ATransformable::ApplyLocationChange(float alpha)
+FSimVector ATransformable::GetPowerValueAt(int powerIndex, double time) const
 {
-	*actualLocation = FMath::Lerp(*oldLocation, *newLocation, alpha);
-	root->SetRelativeLocation(baseLocation + *actualLocation);
+	FSimVector value;
+
+	if (manager == nullptr || !manager->EvaluateTween(this, powerIndex, time, value)) {
+		value = powers.GetPower(powerIndex).actualValue;
+	}
+
+	return value;
 }
 
-void ATransformable::ApplyRotationChange(float alpha)
+void ATransformable::SyncTween(int powerIndex)
 {
-	*actualRotation = FMath::Lerp(*oldRotation, *newRotation, alpha);
-	root->SetRelativeRotation(FQuat(baseRotation + *actualRotation));
+	FSimVector value;
+
+	if (manager != nullptr && manager->EvaluateTween(this, powerIndex, manager->GetTweenTime(), value)) {
+		powers.ApplyTweenValue(powerIndex, value, false);
+	}
 }
 
-void ATransformable::ApplyScaleChange(float alpha)
+void ATransformable::RestoreSnapshot(const FTransformableSnapshot& snapshot)
 {
-	*actualScale = FMath::Lerp(*oldScale, *newScale, alpha);
-	root->SetRelativeScale3D(baseScale + *actualScale);
+	WORKSHOPUE_SCOPE_CYCLE(Reset);
+
+	if (manager != nullptr) {
+		manager->StopTweens(this);
+	}
+
+	powers.RestoreSnapshot(snapshot);
+	ReplicatePowersAtRest();
+
+	// A restore is a teleport, not a move of the kinematic body carrying what rests on it.
+	ApplyTransform(true);
+
+	ChangeColor();
+
+	if (manager != nullptr) {
+		manager->Register(this);
+	}
 }
 
-bool ATransformable::CheckPowerPresent(int index)
+void ATransformable::ApplyTweenValue(int powerIndex, const FSimVector& value, bool bFinished)
 {
-	if (index == 0 && bPower1) {
-		return true;
+	powers.ApplyTweenValue(powerIndex, value, bFinished);
+}
+
+void ATransformable::ApplyTransform(bool bTeleport, bool bUpdateOverlaps, bool bUpdateCollision)
+{
+	WORKSHOPUE_SCOPE_CYCLE(ApplyTransform);
+
+	const FVector location = baseLocation + Powers::ToVector(powers.GetChannelOffset(ETransformChannel::Location));
+	const FRotator rotation = baseRotation + FRotator::MakeFromEuler(Powers::ToVector(powers.GetChannelOffset(ETransformChannel::Rotation)));
+	const FVector scale = baseScale + Powers::ToVector(powers.GetChannelOffset(ETransformChannel::Scale));
+
+	if (location == root->RelativeLocation && rotation == root->RelativeRotation && scale == root->RelativeScale3D) {
+		// Nothing moves, but the bodies may still be where the last render only write left them.
+		if (bUpdateCollision && bCollisionStale) {
+			CommitCollision(bTeleport);
+		}
+		return;
 	}
 
-	if (index == 1 && bPower2) {
-		return true;
+	const bool bRecordHistory = manager != nullptr && manager->IsRecordingHistory();
+	const double now = bRecordHistory ? manager->GetTweenTime() : 0.0;
+
+	if (bRecordHistory) {
+		// Until the last frame the transformable was still where the newest sample left it.
+		const double heldTime = now - GetWorld()->GetDeltaSeconds();
+
+		if (history.IsEmpty() || history.GetNewestTime() < heldTime) {
+			RecordHistory(heldTime);
+		}
 	}
 
-	if (index == 2 && bPower3) {
-		return true;
+	// The overlaps of the root and its children are updated once, at the end of the scope.
+	FScopedMovementUpdate movement(root, EScopedUpdate::DeferredUpdates);
+
+	// One propagation to the children, the render state and the physics body instead of one per channel.
+	root->RelativeLocation = location;
+	root->RelativeRotation = rotation;
+	root->RelativeScale3D = scale;
+	root->UpdateComponentToWorld(bUpdateCollision ? EUpdateTransformFlags::None : EUpdateTransformFlags::SkipPhysicsUpdate,
+		bTeleport ? ETeleportType::TeleportPhysics : ETeleportType::None);
+
+	bCollisionStale = !bUpdateCollision;
+
+	// The overlaps follow the bodies.
+	if (bUpdateOverlaps && bUpdateCollision) {
+		root->UpdateOverlaps();
 	}
 
-	return false;
+	if (bRecordHistory) {
+		RecordHistory(now);
+	}
 }
 
-void ATransformable::PutPowerEffect(int index, UGunComponent * gunComponent)
+void ATransformable::RecordHistory(double time)
 {
-	bool powerTmp = false;
+	history.Record(time, root->GetComponentTransform(), manager->historyCapacity);
+}
 
-	switch (index)
-	{
-	case 0:
-		if (isModifyingLoc) {
-			*oldLocation = *actualLocation;
-		}
+FTransform ATransformable::GetTransformAt(double time) const
+{
+	FTransform transform;
+
+	if (!history.Sample(time, transform)) {
+		transform = root->GetComponentTransform();
+	}
 
-		newLocation.swap(gunComponent->powersStates.position);
+	return transform;
+}
 
-		timerLoc = 0.0;
-		isModifyingLoc = true;
+bool ATransformable::RewindLineTrace(FHitResult& outHit, const FVector& start, const FVector& end, double time)
+{
+	// The ray is mapped through the rendered transform, the bodies must be at the same place.
+	if (bCollisionStale) {
+		CommitCollision(true);
+	}
 
-		powerTmp = bPower1;
-		bPower1 = !newLocation->Equals(FVector::ZeroVector);
+	const FTransform& current = root->GetComponentTransform();
+	const FTransform past = GetTransformAt(time);
 
-		if (bPower1 && powerTmp) {
-			gunComponent->SetPowerAvailable(index);
-		}
-		break;
+	FCollisionQueryParams params(SCENE_QUERY_STAT(RewindLineTrace), true);
+
+	if (past.Equals(current)) {
+		return ActorLineTraceSingle(outHit, start, end, ECollisionChannel::ECC_Visibility, params);
+	}
+
+	// Same point relative to the transformable, then and now.
+	const FVector currentStart = current.TransformPosition(past.InverseTransformPosition(start));
+	const FVector currentEnd = current.TransformPosition(past.InverseTransformPosition(end));
+
+	if (!ActorLineTraceSingle(outHit, currentStart, currentEnd, ECollisionChannel::ECC_Visibility, params)) {
+		return false;
+	}
+
+	outHit.Location = past.TransformPosition(current.InverseTransformPosition(outHit.Location));
+	outHit.ImpactPoint = past.TransformPosition(current.InverseTransformPosition(outHit.ImpactPoint));
+	outHit.Normal = past.TransformVectorNoScale(current.InverseTransformVectorNoScale(outHit.Normal));
+	outHit.ImpactNormal = past.TransformVectorNoScale(current.InverseTransformVectorNoScale(outHit.ImpactNormal));
+	outHit.TraceStart = start;
+	outHit.TraceEnd = end;
 
-	case 1:
-		if (isModifyingRot) {
-			*oldRotation = *actualRotation;
+	return true;
+}
+
+void ATransformable::CommitCollision(bool bTeleport)
+{
+	TInlineComponentArray<UPrimitiveComponent*> primitives(this);
+
+	for (UPrimitiveComponent* primitive : primitives)
+	{
+		if (primitive->BodyInstance.IsValidBodyInstance()) {
+			const FTransform& transform = primitive->GetComponentTransform();
+			primitive->BodyInstance.SetBodyTransform(transform, bTeleport ? ETeleportType::TeleportPhysics : ETeleportType::None);
+			primitive->BodyInstance.UpdateBodyScale(transform.GetScale3D());
 		}
-		newRotation.swap(gunComponent->powersStates.rotation);
-		timerRot = 0.0;
-		isModifyingRot = true;
+	}
+
+	bCollisionStale = false;
+	root->UpdateOverlaps();
+}
 
-		powerTmp = bPower2;
-		bPower2 = !newRotation->Equals(FRotator::ZeroRotator);
+void ATransformable::MakeKinematic()
+{
+	TInlineComponentArray<UPrimitiveComponent*> primitives(this);
 
-		if (bPower2 && powerTmp) {
-			gunComponent->SetPowerAvailable(index);
+	for (UPrimitiveComponent* primitive : primitives)
+	{
+		if (primitive->IsSimulatingPhysics()) {
+			primitive->SetSimulatePhysics(false);
 		}
-		break;
+	}
 
-	case 2:
-		if (isModifyingScale) {
-			*oldScale = *actualScale;
+	// Kinematic targets are only used by movable bodies.
+	root->SetMobility(EComponentMobility::Movable);
+}
+
+uint32 ATransformable::GetTweeningMask() const
+{
+	uint32 mask = 0;
+
+	for (int i = 0; i < Powers::Count; i++) {
+		if (tweenIndices[i] != INDEX_NONE) {
+			mask |= 1u << i;
 		}
-		newScale.swap(gunComponent->powersStates.scale);
-		timerScale = 0.0;
-		isModifyingScale = true;
+	}
+	return mask;
+}
+
+void ATransformable::TransformEffect(int powerIndex, const AActor* instigator)
+{
+	WORKSHOPUE_SCOPE_CYCLE(TransformEffect);
+
+	if (!Powers::IsValid(powerIndex)) {
+		return;
+	}
 
-		powerTmp = bPower3;
-		bPower3 = !newScale->Equals(FVector::ZeroVector);
+	// Restores are decided by the server, clients receive the restored state.
+	if (manager != nullptr && HasAuthority()) {
+		manager->MarkDirty(this, instigator);
+	}
+
+	// The new tween starts from the current value.
+	SyncTween(powerIndex);
+
+	powers.TransformEffect(powerIndex);
+	StartTween(powerIndex);
+
+	// Show the color of the power alone.
+	ApplyColor(1u << powerIndex);
+}
 
-		if (bPower3 && powerTmp) {
-			gunComponent->SetPowerAvailable(index);
+bool ATransformable::CheckPowerPresent(int index) const
+{
+	return powers.HasPower(index);
+}
+
+void ATransformable::PutPowerEffect(int index, UGunComponent * gunComponent)
+{
+	WORKSHOPUE_SCOPE_CYCLE(PutPowerEffect);
+
+	if (Powers::IsValid(index)) {
+		// Restored with the baseline of the character holding the gun, by the server.
+		if (manager != nullptr && HasAuthority()) {
+			manager->MarkDirty(this, gunComponent->GetOwner());
 		}
-		break;
 
-	default: break;
+		SyncTween(index);
+
+		powers.PutPowerEffect(index, gunComponent->GetPowers());
+		StartTween(index);
+
+		// The power may have been given back to the gun.
+		gunComponent->SchedulePowerChanges();
 	}
 
 	ChangeColor();
 }
 
+void ATransformable::PredictPowerEffect(int index, UGunComponent* gunComponent)
+{
+	PutPowerEffect(index, gunComponent);
+	bPredicted = true;
+}
+
 void ATransformable::ChangeColor() {
+	ApplyColor(powers.GetMask());
+}
 
-	float r = 0.0f, g = 0.0f, b = 0.0f; // Black
-
-	if (bPower1) {
-		if (bPower2) {
-			if (bPower3) {
-				r = g = b = 1.0f; // White
-			}
-			else {
-				r = 1.0f; // Orange
-				g = 0.5f;
-			}
-		}
-		else {
-			if (bPower3) {
-				r = 0.5f; // Turquoise
-				b = 1.0f;
-			}
-			else {
-				r = 1.0f; // Red
-			}
-		}
+void ATransformable::ApplyColor(uint32 mask) {
+
+	if (mask == colorMask) {
+		return;
 	}
-	else {
-		if (bPower2) {
-			if (bPower3) {
-				g = 1.0f; // Purple
-				b = 0.5;
-			}
-			else {
-				g = 1.0f; // Green
-			}
-		}
-		else {
-			if (bPower3) {
-				b = 1.0f; // Blue
-			}
-		}
+	colorMask = mask;
+
+	// Native path: swap to the shared instance of this mask.
+	if (colorMesh != nullptr && manager != nullptr) {
+		colorMesh->SetMaterial(materialIndex, manager->GetPowerMaterial(powerMaterial, colorParameterName, mask));
+		return;
 	}
 
-	ChangeColor(FVector(r, g, b));
+	ChangeColor(Powers::ToVector(Powers::GetMaskColor(mask)));
 }
@@ -3,12 +3,38 @@
 #pragma once
 
 #include "Engine.h"
-#include <memory>
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "GunComponent.h"
+#include "PowerTable.h"
+#include "TransformableManager.h"
+#include "TransformableHistory.h"
+#include "Simulation/TransformablePowers.h"
 #include "Transformable.generated.h"
 
+/*
+ * Change of a power replicated to the clients, which rebuild the tween locally.
+ * Transforms are never replicated, only the value a power goes to and when it started.
+ */
+USTRUCT()
+struct FTransformablePowerEvent
+{
+	GENERATED_BODY()
+
+	/* New value of the power, quantized to 1/100. */
+	UPROPERTY()
+	FVector_NetQuantize100 value;
+
+	/* Server time the tween started, negative if the power was set at rest. */
+	UPROPERTY()
+	float startTime;
+
+	FTransformablePowerEvent() : value(FVector::ZeroVector), startTime(-1.0f) {}
+
+	bool operator==(const FTransformablePowerEvent& other) const { return value == other.value && startTime == other.startTime; }
+};
+
+/* Engine adapter of FTransformablePowers: tweens, root component transform and colors. */
 UCLASS()
 class WORKSHOPUE_API ATransformable : public AActor
 {
@@ -18,69 +44,187 @@ public:
 	UPROPERTY(EditAnywhere, Category = Gameplay)
 	float timeToChange;
 
-	bool isModifyingLoc;
-	FVector baseLocation;
+	/* Initial values, given to the first power of each channel. */
 	UPROPERTY(EditAnywhere, Category = Gameplay)
 	FVector initialLocation;
-	std::shared_ptr<FVector> oldLocation;
-	std::shared_ptr<FVector> actualLocation;
-	std::shared_ptr<FVector> newLocation;
-
-	bool isModifyingRot;
-	FRotator baseRotation;
 	UPROPERTY(EditAnywhere, Category = Gameplay)
 	FRotator initialRotation;
-	std::shared_ptr<FRotator> oldRotation;
-	std::shared_ptr<FRotator> actualRotation;
-	std::shared_ptr<FRotator> newRotation;
-
-	bool isModifyingScale;
-	FVector baseScale;
 	UPROPERTY(EditAnywhere, Category = Gameplay)
 	FVector initialScale;
-	std::shared_ptr<FVector> oldScale;
-	std::shared_ptr<FVector> actualScale;
-	std::shared_ptr<FVector> newScale;
+
+	/** Material colored with the powers. If set, colors are shared material instances, ChangeColor(FVector) is not called. */
+	UPROPERTY(EditAnywhere, Category = Rendering)
+	class UMaterialInterface* powerMaterial;
+
+	/** Vector parameter of powerMaterial receiving the color. */
+	UPROPERTY(EditAnywhere, Category = Rendering)
+	FName colorParameterName;
+
+	/** Material slot of the mesh using powerMaterial. */
+	UPROPERTY(EditAnywhere, Category = Rendering)
+	int materialIndex;
+
+	FVector baseLocation;
+	FRotator baseRotation;
+	FVector baseScale;
+
+	/* State of each power, indexed like Powers::Table. */
+	FTransformablePowers powers;
 
 private:
 	class USceneComponent *root;
 
-	float timerLoc;
-	float timerRot;
-	float timerScale;
+	/* Mesh receiving the power materials. */
+	UPROPERTY()
+	class UMeshComponent* colorMesh;
+
+	/* Power mask of the color currently displayed. */
+	uint32 colorMask;
+
+	/* Manager updating the tweens of this transformable. */
+	UPROPERTY()
+	ATransformableManager* manager;
+
+	/* Index of each power tween in the manager, INDEX_NONE when idle. */
+	int tweenIndices[Powers::Count];
+
+	/* Index in the spatial grid of the manager, INDEX_NONE when not registered. */
+	int gridIndex;
+
+	/* Last change of each power, indexed like Powers::Table, written by the server. */
+	UPROPERTY(ReplicatedUsing = OnRep_PowerEvents)
+	TArray<FTransformablePowerEvent> powerEvents;
+
+	UFUNCTION()
+	void OnRep_PowerEvents(const TArray<FTransformablePowerEvent>& previousEvents);
+
+	/* Power events received before BeginPlay, applied by BeginPlay. Client only. */
+	bool bPowerEventsPending;
+
+	/* Powers changed by a prediction of the owning client which no power event has confirmed yet. Client only. */
+	bool bPredicted;
+
+	/* Region containing the transformable when it began play, null if none. Server only. */
+	UPROPERTY()
+	class ANetRegionVolume* netRegion;
+
+	/* Instigators with an entry for this transformable in the dirty set of the manager. */
+	TArray<TWeakObjectPtr<const AActor>, TInlineAllocator<2>> dirtyInstigators;
+
+	/* True while the manager has a transform to write for this transformable this frame. */
+	bool bTransformPending;
+
+	/* True while the physics bodies lag behind the render transform. */
+	bool bCollisionStale;
+
+	/* Tween clock time of the last transform write with collision. */
+	double collisionCommitTime;
+
+	/* Move the physics bodies to the current transform of their components. */
+	void CommitCollision(bool bTeleport);
+
+	/* Recent world transforms of the root, recorded by a server with remote players. */
+	FTransformableHistory history;
+
+	/* Add the current world transform of the root to the history. */
+	void RecordHistory(double time);
+
+	friend class ATransformableManager;
+	friend class FTransformableGrid;
 
 public:
 	// Sets default values for this actor's properties
 	ATransformable();
 
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/* Relevant to the viewers of its region, see ANetRegionVolume. */
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+	/* Called by the manager with the interpolated value of a power tween, the transform is written by ApplyTransform. */
+	void ApplyTweenValue(int powerIndex, const FSimVector& value, bool bFinished);
+
+	/*
+	 * Write the actual values of every channel to the root component as a single transform update.
+	 * Without bUpdateCollision only the render transform moves, the physics bodies and the overlaps stay
+	 * where they were until the next write with bUpdateCollision.
+	 * Overlaps of the root and its children are only updated if bUpdateOverlaps is true.
+	 */
+	void ApplyTransform(bool bTeleport = false, bool bUpdateOverlaps = true, bool bUpdateCollision = true);
+
+	/* Stop the physics simulation of the bodies, they are moved by kinematic targets. */
+	void MakeKinematic();
+
+	/* Powers currently tweening, one bit per power index. */
+	uint32 GetTweeningMask() const;
+
+	/* Value of a power at a time of the tween clock of the manager, evaluated from its tween if it is tweening. */
+	FSimVector GetPowerValueAt(int powerIndex, double time) const;
+
+	/* World transform of the root at a past time of the tween clock, from the history if it is recorded. */
+	FTransform GetTransformAt(double time) const;
+
+	/*
+	 * Trace a segment against the transformable as it was at a past time of the tween clock.
+	 * The segment is moved along with the transformable from then to now and traced against the current collision,
+	 * the hit is given back where it was at that time.
+	 * Collision left behind by a render only tween is committed first.
+	 */
+	bool RewindLineTrace(FHitResult& outHit, const FVector& start, const FVector& end, double time);
 
 	UFUNCTION(BlueprintImplementableEvent, category = "CppFunctions")
 	void ChangeColor(FVector color);
 
-	void TransformEffect(int powerIndex);
+	/* Add the effect of a power, instigator is the character restoring it with its baseline, if any. */
+	void TransformEffect(int powerIndex, const AActor* instigator);
 
 	/* Check if the specified power is present on this transformable */
-	bool CheckPowerPresent(int index);
+	bool CheckPowerPresent(int index) const;
+
+	/* Powers present on this transformable, one bit per power index. */
+	uint32 GetPowerMask() const { return powers.GetMask(); }
 
 	/* Put effect on transformable and swap if same power already exist. */
 	void PutPowerEffect(int index, UGunComponent* gunComponent);
 
-	void Reset();
+	/* PutPowerEffect predicted by the owning client, until the power events of the server confirm or correct it. */
+	void PredictPowerEffect(int index, UGunComponent* gunComponent);
+
+	/* Tween the powers back to the last state replicated by the server, from where they are. Client only. */
+	void Reconcile();
+
+	/* Record the state at rest of the powers, tweens in progress are recorded at their end. */
+	void CaptureSnapshot(FTransformableSnapshot& snapshot) const { powers.CaptureSnapshot(snapshot); }
+
+	/* Stop the tweens and set the powers back to a recorded state. */
+	void RestoreSnapshot(const FTransformableSnapshot& snapshot);
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-private:
-	void ApplyLocationChange(float alpha);
-	void ApplyRotationChange(float alpha);
-	void ApplyScaleChange(float alpha);
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	bool bPower1, bPower2, bPower3;
+private:
+	FVector GetInitialValue(int powerIndex) const;
 
 	void Setup();
 
+	/* Tween a power from its old value to its new value, from now or from a time of the tween clock. */
+	void StartTween(int powerIndex);
+	void StartTween(int powerIndex, double startTime);
+
+	/* Record the state of a power for the clients, at rest if startTime is negative. Server only. */
+	void ReplicatePower(int powerIndex, float startTime);
+
+	/* Record the state at rest of every power for the clients. Server only. */
+	void ReplicatePowersAtRest();
+
+	/* Set the actual value of a tweening power to the value of its tween now, it may not be applied every frame. */
+	void SyncTween(int powerIndex);
+
 	void ChangeColor();
+
+	/* Display the color of a power mask, does nothing if it is already displayed. */
+	void ApplyColor(uint32 mask);
 };
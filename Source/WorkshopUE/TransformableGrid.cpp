@@ -0,0 +1,313 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TransformableGrid.h"
+#include "Transformable.h"
+
+FTransformableGrid::FTransformableGrid(float inCellSize)
+	: cellSize(inCellSize)
+	, invCellSize(1.0f / inCellSize)
+	, queryCounter(0)
+{
+}
+
+FIntVector FTransformableGrid::ToCell(const FVector& location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(location.X * invCellSize),
+		FMath::FloorToInt(location.Y * invCellSize),
+		FMath::FloorToInt(location.Z * invCellSize));
+}
+
+void FTransformableGrid::Add(ATransformable* transformable, const FBox& bounds)
+{
+	if (transformable->gridIndex != INDEX_NONE) {
+		Update(transformable, bounds);
+		return;
+	}
+
+	FEntry entry;
+	entry.transformable = transformable;
+	entry.bounds = bounds;
+	entry.minCell = ToCell(bounds.Min);
+	entry.maxCell = ToCell(bounds.Max);
+	entry.queryStamp = 0;
+
+	const int32 entryIndex = entries.Add(entry);
+	transformable->gridIndex = entryIndex;
+
+	AddToCells(entryIndex);
+}
+
+void FTransformableGrid::Update(ATransformable* transformable, const FBox& bounds)
+{
+	const int32 entryIndex = transformable->gridIndex;
+	if (entryIndex == INDEX_NONE) {
+		return;
+	}
+
+	FEntry& entry = entries[entryIndex];
+	entry.bounds = bounds;
+
+	const FIntVector minCell = ToCell(bounds.Min);
+	const FIntVector maxCell = ToCell(bounds.Max);
+
+	// Most frames a moving transformable stays in the same cells.
+	if (minCell == entry.minCell && maxCell == entry.maxCell) {
+		return;
+	}
+
+	RemoveFromCells(entryIndex);
+	entry.minCell = minCell;
+	entry.maxCell = maxCell;
+	AddToCells(entryIndex);
+}
+
+void FTransformableGrid::Remove(ATransformable* transformable)
+{
+	const int32 entryIndex = transformable->gridIndex;
+	if (entryIndex == INDEX_NONE) {
+		return;
+	}
+
+	RemoveFromCells(entryIndex);
+	entries.RemoveAt(entryIndex);
+	transformable->gridIndex = INDEX_NONE;
+}
+
+void FTransformableGrid::AddToCells(int32 entryIndex)
+{
+	const FEntry& entry = entries[entryIndex];
+
+	for (int x = entry.minCell.X; x <= entry.maxCell.X; x++)
+	for (int y = entry.minCell.Y; y <= entry.maxCell.Y; y++)
+	for (int z = entry.minCell.Z; z <= entry.maxCell.Z; z++)
+	{
+		cells.FindOrAdd(FIntVector(x, y, z)).Add(entryIndex);
+	}
+}
+
+void FTransformableGrid::RemoveFromCells(int32 entryIndex)
+{
+	const FEntry& entry = entries[entryIndex];
+
+	for (int x = entry.minCell.X; x <= entry.maxCell.X; x++)
+	for (int y = entry.minCell.Y; y <= entry.maxCell.Y; y++)
+	for (int z = entry.minCell.Z; z <= entry.maxCell.Z; z++)
+	{
+		const FIntVector cell(x, y, z);
+		TArray<int32>* cellEntries = cells.Find(cell);
+
+		if (cellEntries) {
+			cellEntries->RemoveSingleSwap(entryIndex, false);
+
+			if (cellEntries->Num() == 0) {
+				cells.Remove(cell);
+			}
+		}
+	}
+}
+
+bool FTransformableGrid::MatchPowers(const FEntry& entry, uint32 powerMask) const
+{
+	return powerMask == 0 || (entry.transformable->GetPowerMask() & powerMask) != 0;
+}
+
+template<typename VisitorType>
+void FTransformableGrid::VisitBox(const FBox& box, uint32 powerMask, VisitorType visitor) const
+{
+	const uint32 stamp = ++queryCounter;
+
+	const FIntVector minCell = ToCell(box.Min);
+	const FIntVector maxCell = ToCell(box.Max);
+
+	for (int x = minCell.X; x <= maxCell.X; x++)
+	for (int y = minCell.Y; y <= maxCell.Y; y++)
+	for (int z = minCell.Z; z <= maxCell.Z; z++)
+	{
+		const TArray<int32>* cellEntries = cells.Find(FIntVector(x, y, z));
+		if (cellEntries == nullptr) {
+			continue;
+		}
+
+		for (int32 entryIndex : *cellEntries)
+		{
+			const FEntry& entry = entries[entryIndex];
+
+			if (entry.queryStamp == stamp) {
+				continue;
+			}
+			entry.queryStamp = stamp;
+
+			if (MatchPowers(entry, powerMask)) {
+				visitor(entry);
+			}
+		}
+	}
+}
+
+void FTransformableGrid::QueryRadius(const FVector& center, float radius, uint32 powerMask, TArray<ATransformable*>& outTransformables) const
+{
+	const FBox queryBox(center - FVector(radius), center + FVector(radius));
+	const float radiusSquared = radius * radius;
+
+	VisitBox(queryBox, powerMask, [&](const FEntry& entry) {
+		if (entry.bounds.ComputeSquaredDistanceToPoint(center) <= radiusSquared) {
+			outTransformables.Add(entry.transformable);
+		}
+	});
+}
+
+void FTransformableGrid::QueryCone(const FVector& origin, const FVector& direction, float halfAngleDegrees, float length, uint32 powerMask, TArray<ATransformable*>& outTransformables) const
+{
+	const FVector axis = direction.GetSafeNormal();
+	const float halfAngle = FMath::DegreesToRadians(FMath::Clamp(halfAngleDegrees, 0.0f, 89.0f));
+
+	// Bounding box of the cone.
+	const FVector tip = origin + axis * length;
+	FBox queryBox(origin, origin);
+	queryBox += tip;
+	queryBox = queryBox.ExpandBy(length * FMath::Tan(halfAngle));
+
+	TArray<TPair<float, ATransformable*>> found;
+
+	VisitBox(queryBox, powerMask, [&](const FEntry& entry) {
+		// Test the bounding sphere of the entry against the cone.
+		FVector center, extent;
+		entry.bounds.GetCenterAndExtents(center, extent);
+		const float radius = extent.Size();
+
+		const FVector toCenter = center - origin;
+		const float distance = toCenter.Size();
+
+		if (distance - radius > length) {
+			return;
+		}
+
+		if (distance > radius) {
+			const float angle = FMath::Acos(FMath::Clamp(FVector::DotProduct(axis, toCenter / distance), -1.0f, 1.0f));
+			if (angle > halfAngle + FMath::Asin(radius / distance)) {
+				return;
+			}
+		}
+
+		found.Emplace(distance, entry.transformable);
+	});
+
+	found.Sort([](const TPair<float, ATransformable*>& a, const TPair<float, ATransformable*>& b) {
+		return a.Key < b.Key;
+	});
+
+	for (const TPair<float, ATransformable*>& pair : found)
+	{
+		outTransformables.Add(pair.Value);
+	}
+}
+
+/* Distance along the ray to the box, slab test. */
+static bool IntersectRayBox(const FVector& start, const FVector& invDirection, float length, const FBox& box, float& outDistance)
+{
+	float tMin = 0.0f;
+	float tMax = length;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float t0 = (box.Min[axis] - start[axis]) * invDirection[axis];
+		float t1 = (box.Max[axis] - start[axis]) * invDirection[axis];
+		if (t0 > t1) {
+			Swap(t0, t1);
+		}
+
+		tMin = FMath::Max(tMin, t0);
+		tMax = FMath::Min(tMax, t1);
+
+		if (tMin > tMax) {
+			return false;
+		}
+	}
+
+	outDistance = tMin;
+	return true;
+}
+
+ATransformable* FTransformableGrid::QueryRay(const FVector& start, const FVector& end, uint32 powerMask, float* outDistance) const
+{
+	const FVector delta = end - start;
+	const float length = delta.Size();
+	if (length <= SMALL_NUMBER) {
+		return nullptr;
+	}
+
+	const FVector direction = delta / length;
+	const FVector invDirection(
+		direction.X != 0.0f ? 1.0f / direction.X : BIG_NUMBER,
+		direction.Y != 0.0f ? 1.0f / direction.Y : BIG_NUMBER,
+		direction.Z != 0.0f ? 1.0f / direction.Z : BIG_NUMBER);
+
+	const uint32 stamp = ++queryCounter;
+
+	ATransformable* nearest = nullptr;
+	float nearestDistance = length;
+
+	// Walk the cells crossed by the segment in order (3D DDA).
+	FIntVector cell = ToCell(start);
+	const FIntVector endCell = ToCell(end);
+
+	const FIntVector step(direction.X >= 0.0f ? 1 : -1, direction.Y >= 0.0f ? 1 : -1, direction.Z >= 0.0f ? 1 : -1);
+
+	FVector tMax, tDelta;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float boundary = (cell[axis] + (step[axis] > 0 ? 1 : 0)) * cellSize;
+		tMax[axis] = direction[axis] != 0.0f ? (boundary - start[axis]) * invDirection[axis] : BIG_NUMBER;
+		tDelta[axis] = direction[axis] != 0.0f ? cellSize * FMath::Abs(invDirection[axis]) : BIG_NUMBER;
+	}
+
+	float cellEnter = 0.0f;
+
+	while (true)
+	{
+		// Nothing in the next cells can be nearer than a hit already found.
+		if (cellEnter > nearestDistance) {
+			break;
+		}
+
+		const TArray<int32>* cellEntries = cells.Find(cell);
+		if (cellEntries) {
+			for (int32 entryIndex : *cellEntries)
+			{
+				const FEntry& entry = entries[entryIndex];
+
+				if (entry.queryStamp == stamp) {
+					continue;
+				}
+				entry.queryStamp = stamp;
+
+				float distance;
+				if (MatchPowers(entry, powerMask) && IntersectRayBox(start, invDirection, length, entry.bounds, distance) && distance < nearestDistance) {
+					nearest = entry.transformable;
+					nearestDistance = distance;
+				}
+			}
+		}
+
+		if (cell == endCell) {
+			break;
+		}
+
+		// Step to the next cell along the axis with the nearest boundary.
+		const int axis = tMax.X < tMax.Y ? (tMax.X < tMax.Z ? 0 : 2) : (tMax.Y < tMax.Z ? 1 : 2);
+		if (tMax[axis] > length) {
+			break;
+		}
+
+		cellEnter = tMax[axis];
+		cell[axis] += step[axis];
+		tMax[axis] += tDelta[axis];
+	}
+
+	if (outDistance) {
+		*outDistance = nearestDistance;
+	}
+
+	return nearest;
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ATransformable;
+
+/*
+ * Uniform grid of the transformables of a world, indexed by their bounds.
+ * Answers ray, cone and radius queries without going through the physics scene.
+ * Queries can be filtered by a mask of powers: only transformables holding at least one of these powers are returned.
+ */
+class WORKSHOPUE_API FTransformableGrid
+{
+public:
+	explicit FTransformableGrid(float cellSize = 1000.0f);
+
+	void Add(ATransformable* transformable, const FBox& bounds);
+
+	/* Update the bounds of a transformable, cells are only rewritten when the covered cells change. */
+	void Update(ATransformable* transformable, const FBox& bounds);
+
+	void Remove(ATransformable* transformable);
+
+	/* Transformables whose bounds intersect the sphere. */
+	void QueryRadius(const FVector& center, float radius, uint32 powerMask, TArray<ATransformable*>& outTransformables) const;
+
+	/* Transformables whose bounds intersect the cone, sorted from the nearest to the farthest. */
+	void QueryCone(const FVector& origin, const FVector& direction, float halfAngleDegrees, float length, uint32 powerMask, TArray<ATransformable*>& outTransformables) const;
+
+	/* Nearest transformable whose bounds are crossed by the segment, nullptr if none. */
+	ATransformable* QueryRay(const FVector& start, const FVector& end, uint32 powerMask, float* outDistance = nullptr) const;
+
+	int Num() const { return entries.Num(); }
+
+private:
+	struct FEntry
+	{
+		ATransformable* transformable;
+		FBox bounds;
+		FIntVector minCell;
+		FIntVector maxCell;
+
+		/* Last query which visited this entry, avoid returning it once per cell. */
+		mutable uint32 queryStamp;
+	};
+
+	float cellSize;
+	float invCellSize;
+
+	TSparseArray<FEntry> entries;
+	TMap<FIntVector, TArray<int32>> cells;
+
+	mutable uint32 queryCounter;
+
+	FIntVector ToCell(const FVector& location) const;
+
+	void AddToCells(int32 entryIndex);
+	void RemoveFromCells(int32 entryIndex);
+
+	/* Call visitor once for each entry of the cells overlapping the box and matching the power mask. */
+	template<typename VisitorType>
+	void VisitBox(const FBox& box, uint32 powerMask, VisitorType visitor) const;
+
+	bool MatchPowers(const FEntry& entry, uint32 powerMask) const;
+};
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TransformableHistory.h"
+
+FTransformableHistory::FTransformableHistory()
+{
+	head = 0;
+	count = 0;
+}
+
+void FTransformableHistory::Record(double time, const FTransform& transform, int capacity)
+{
+	capacity = FMath::Max(capacity, 2);
+
+	if (samples.Num() != capacity) {
+		samples.SetNum(capacity);
+		head = 0;
+		count = 0;
+	}
+
+	if (count > 0) {
+		const double newestTime = GetNewestTime();
+
+		if (time < newestTime) {
+			return;
+		}
+		if (time == newestTime) {
+			samples[(head + capacity - 1) % capacity].transform = transform;
+			return;
+		}
+	}
+
+	FSample& sample = samples[head];
+	sample.time = time;
+	sample.transform = transform;
+
+	head = (head + 1) % capacity;
+	count = FMath::Min(count + 1, capacity);
+}
+
+bool FTransformableHistory::Sample(double time, FTransform& outTransform) const
+{
+	if (count == 0) {
+		return false;
+	}
+
+	// Rewinds are short, walk back from the newest sample.
+	const FSample* newer = &GetSample(0);
+
+	if (time >= newer->time) {
+		outTransform = newer->transform;
+		return true;
+	}
+
+	for (int age = 1; age < count; age++)
+	{
+		const FSample& older = GetSample(age);
+
+		if (time >= older.time) {
+			const float alpha = (float)((time - older.time) / (newer->time - older.time));
+			outTransform.Blend(older.transform, newer->transform, alpha);
+			return true;
+		}
+		newer = &older;
+	}
+
+	outTransform = newer->transform;
+	return true;
+}
+
+double FTransformableHistory::GetNewestTime() const
+{
+	return count > 0 ? GetSample(0).time : 0.0;
+}
+
+const FTransformableHistory::FSample& FTransformableHistory::GetSample(int age) const
+{
+	const int capacity = samples.Num();
+	return samples[(head + capacity - 1 - age) % capacity];
+}
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+ * Fixed-size ring buffer of the recent world transforms of a transformable.
+ * Recorded by the server, so the hits claimed by clients are checked against where the transformable was when they aimed.
+ * The buffer is only allocated by the first record, transformables which never move cost nothing.
+ */
+class WORKSHOPUE_API FTransformableHistory
+{
+public:
+	FTransformableHistory();
+
+	/*
+	 * Add a sample, the oldest one is overwritten once capacity samples are recorded.
+	 * A sample at the time of the newest one replaces it, older times are ignored.
+	 */
+	void Record(double time, const FTransform& transform, int capacity);
+
+	/*
+	 * Transform at a time, interpolated between the samples around it and clamped to the oldest and newest ones.
+	 * Return false if nothing is recorded.
+	 */
+	bool Sample(double time, FTransform& outTransform) const;
+
+	bool IsEmpty() const { return count == 0; }
+
+	double GetNewestTime() const;
+
+private:
+	struct FSample
+	{
+		double time;
+		FTransform transform;
+	};
+
+	TArray<FSample> samples;
+
+	/* Index of the next sample written. */
+	int head;
+	int count;
+
+	/* Sample recorded age samples before the newest one. */
+	const FSample& GetSample(int age) const;
+};
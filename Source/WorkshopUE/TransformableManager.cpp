@@ -0,0 +1,547 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TransformableManager.h"
+#include "Transformable.h"
+#include "WorldManager.h"
+#include "NetRegionVolume.h"
+#include "WorkshopUEStats.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Kismet/GameplayStatics.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/GameStateBase.h"
+
+// Margin added to the field of view, for the camera turning between two updates.
+static const float ViewAngleMargin = 10.0f;
+
+// Sets default values
+ATransformableManager::ATransformableManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Ticks every frame to advance the tween clock, the tweens and the restores are only updated while pending.
+	PrimaryActorTick.bStartWithTickEnabled = true;
+
+	tweenClock = 0.0;
+	tweenClockFrame = 0;
+	bTweenClockStarted = false;
+
+	bTeleportTweens = false;
+	bKinematicTweens = false;
+	bUpdateOverlapsWhileTweening = true;
+	bRenderOnlyLocationTweens = false;
+	bRenderOnlyRotationTweens = false;
+	bRenderOnlyScaleTweens = true;
+	collisionCommitRate = 10.0f;
+
+	bUseSignificance = true;
+	fullRateDistance = 2000.0f;
+	reducedRateDistance = 8000.0f;
+	reducedRateInterval = 4;
+	renderedTolerance = 0.2f;
+
+	bHasView = false;
+	viewLocation = FVector::ZeroVector;
+	viewDirection = FVector::ForwardVector;
+	viewCosHalfAngle = -1.0f;
+	frameIndex = 0;
+	viewerRegionsFrame = 0;
+
+	maxRewindTime = 0.3f;
+	historyCapacity = 32;
+}
+
+ATransformableManager* ATransformableManager::Get(UWorld* world)
+{
+	return FindOrSpawnWorldManager<ATransformableManager>(world);
+}
+
+// Called every frame
+void ATransformableManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	AdvanceTweenClock();
+
+	if (tweenOwners.Num() == 0 && pendingRestores.Num() == 0) {
+		return;
+	}
+
+	WORKSHOPUE_SCOPE_CYCLE(Tweens);
+
+	const int count = tweenOwners.Num();
+
+	TweenKernel::ComputeAlphas(count, GetTweenTime(), tweenStartTime.GetData(), tweenInvDuration.GetData(), tweenAlpha.GetData());
+	TweenKernel::Interpolate(count, tweenAlpha.GetData(), tweenFrom.GetData(), tweenTo.GetData(), tweenValue.GetData());
+
+	UpdateView();
+	frameIndex++;
+
+	int throttled = 0;
+
+	// Iterate backward, finished tweens are swapped out of the arrays.
+	for (int i = count - 1; i >= 0; i--)
+	{
+		const FTweenOwner owner = tweenOwners[i];
+
+		const bool bFinished = tweenAlpha[i] >= 1.0f;
+
+		// Finished tweens are always applied, they end at the right time whatever their significance.
+		if (!bFinished && bUseSignificance) {
+			const ETweenSignificance significance = GetSignificance(owner.transformable);
+
+			if (significance == ETweenSignificance::Completion
+				|| (significance == ETweenSignificance::Reduced && (frameIndex + (uint32)owner.transformable->gridIndex) % FMath::Max(reducedRateInterval, 1) != 0)) {
+				throttled++;
+				continue;
+			}
+		}
+
+		const FSimVector value = tweenValue[i].ToSim();
+
+		if (bFinished) {
+			RemoveAt(i);
+		}
+
+		owner.transformable->ApplyTweenValue(owner.powerIndex, value, bFinished);
+
+		if (!owner.transformable->bTransformPending) {
+			owner.transformable->bTransformPending = true;
+			pendingTransforms.Add(owner.transformable);
+		}
+	}
+
+	const double now = GetTweenTime();
+	const uint32 renderOnlyMask = GetRenderOnlyMask();
+	const double commitInterval = collisionCommitRate > 0.0f ? 1.0 / collisionCommitRate : TNumericLimits<double>::Max();
+
+	// One transform write per transformable, whatever the number of channels tweening.
+	for (ATransformable* transformable : pendingTransforms)
+	{
+		transformable->bTransformPending = false;
+
+		const uint32 tweeningMask = transformable->GetTweeningMask();
+
+		// Collision follows at the commit rate while a render only channel is tweening, and always when it ends.
+		const bool bUpdateCollision = (tweeningMask & renderOnlyMask) == 0 || now - transformable->collisionCommitTime >= commitInterval;
+		if (bUpdateCollision) {
+			transformable->collisionCommitTime = now;
+		}
+
+		// Overlaps are always updated when the last tween ends.
+		transformable->ApplyTransform(bTeleportTweens && !bKinematicTweens, bUpdateOverlapsWhileTweening || tweeningMask == 0, bUpdateCollision);
+		grid.Update(transformable, transformable->GetComponentsBoundingBox());
+	}
+	pendingTransforms.Reset();
+
+	WORKSHOPUE_SET_COUNTER(ThrottledTweens, throttled);
+
+	for (const FPendingRestore& restore : pendingRestores) {
+		RestoreDirty(restore.instigator, restore.budget);
+	}
+
+	FinishRestores();
+}
+
+uint32 ATransformableManager::GetRenderOnlyMask() const
+{
+	uint32 mask = 0;
+
+	for (int i = 0; i < Powers::Count; i++)
+	{
+		const ETransformChannel channel = Powers::Table[i].channel;
+
+		// Kinematic bodies follow their location and rotation every frame.
+		if ((channel == ETransformChannel::Location && bRenderOnlyLocationTweens && !bKinematicTweens)
+			|| (channel == ETransformChannel::Rotation && bRenderOnlyRotationTweens && !bKinematicTweens)
+			|| (channel == ETransformChannel::Scale && bRenderOnlyScaleTweens)) {
+			mask |= 1u << i;
+		}
+	}
+	return mask;
+}
+
+double ATransformableManager::GetTweenTime() const
+{
+	AdvanceTweenClock();
+	return tweenClock;
+}
+
+void ATransformableManager::AdvanceTweenClock() const
+{
+	const UWorld* world = GetWorld();
+
+	if (world == nullptr || (bTweenClockStarted && tweenClockFrame == GFrameCounter)) {
+		return;
+	}
+
+	// The time of the world is a float, only its delta times are accumulated, from the time the clock starts at.
+	// Starting at the time of the world keeps the clock comparable with the server time of the game state.
+	if (!bTweenClockStarted) {
+		tweenClock = world->GetTimeSeconds();
+		bTweenClockStarted = true;
+	}
+	else if (!world->IsPaused()) {
+		tweenClock += world->GetDeltaSeconds();
+	}
+	tweenClockFrame = GFrameCounter;
+}
+
+double ATransformableManager::GetServerTime() const
+{
+	const UWorld* world = GetWorld();
+	const AGameStateBase* gameState = world != nullptr ? world->GetGameState() : nullptr;
+
+	return HasAuthority() || gameState == nullptr ? GetTweenTime() : gameState->GetServerWorldTimeSeconds();
+}
+
+bool ATransformableManager::IsRecordingHistory() const
+{
+	const ENetMode netMode = GetNetMode();
+	return maxRewindTime > 0.0f && (netMode == NM_DedicatedServer || netMode == NM_ListenServer);
+}
+
+double ATransformableManager::ClampRewindTime(double time) const
+{
+	const double now = GetTweenTime();
+	return FMath::Clamp(time, now - maxRewindTime, now);
+}
+
+ATransformable* ATransformableManager::RewindLineTrace(const FVector& start, const FVector& end, double time, FHitResult& outHit) const
+{
+	TArray<ATransformable*> candidates;
+	grid.QueryRadius((start + end) * 0.5f, FVector::Dist(start, end) * 0.5f, 0, candidates);
+
+	ATransformable* nearest = nullptr;
+	FHitResult hit;
+
+	for (ATransformable* transformable : candidates)
+	{
+		if (transformable->RewindLineTrace(hit, start, end, time) && (nearest == nullptr || hit.Time < outHit.Time)) {
+			nearest = transformable;
+			outHit = hit;
+		}
+	}
+
+	return nearest;
+}
+
+bool ATransformableManager::IsSegmentOccluded(const FVector& start, const FVector& end, const AActor* ignoredActor) const
+{
+	// Transformables moved since the shot, a blocking one is skipped and the trace goes on behind it.
+	static const int MaxSkippedTransformables = 8;
+
+	FCollisionQueryParams params(SCENE_QUERY_STAT(SegmentOcclusion), true);
+	params.AddIgnoredActor(ignoredActor);
+
+	for (int i = 0; i <= MaxSkippedTransformables; i++)
+	{
+		FHitResult hit;
+		if (!GetWorld()->LineTraceSingleByChannel(hit, start, end, ECollisionChannel::ECC_Visibility, params)) {
+			return false;
+		}
+
+		AActor* actor = hit.GetActor();
+		if (Cast<ATransformable>(actor) == nullptr) {
+			return true;
+		}
+		params.AddIgnoredActor(actor);
+	}
+
+	return false;
+}
+
+const ANetRegionVolume* ATransformableManager::GetViewerRegion(const AActor* viewer, const FVector& viewLocation)
+{
+	// The viewers don't move during the net update of a frame.
+	if (viewerRegionsFrame != GFrameCounter) {
+		viewerRegions.Reset();
+		viewerRegionsFrame = GFrameCounter;
+	}
+
+	const ANetRegionVolume** region = viewerRegions.Find(viewer);
+	if (region != nullptr) {
+		return *region;
+	}
+
+	return viewerRegions.Add(viewer, ANetRegionVolume::Find(GetWorld(), viewLocation));
+}
+
+bool ATransformableManager::EvaluateTween(const ATransformable* transformable, int powerIndex, double time, FSimVector& value) const
+{
+	const int index = transformable->tweenIndices[powerIndex];
+
+	if (index == INDEX_NONE) {
+		return false;
+	}
+
+	const float alpha = TweenKernel::ComputeAlpha(time, tweenStartTime[index], tweenInvDuration[index]);
+
+	FTweenVector result;
+	TweenKernel::Interpolate(1, &alpha, &tweenFrom[index], &tweenTo[index], &result);
+	value = result.ToSim();
+
+	return true;
+}
+
+void ATransformableManager::UpdateView()
+{
+	// Throttled tweens leave the collision, the grid and the transform history behind, only a standalone game
+	// can afford it: a server validates the shots of remote players against them and clients predict against them.
+	const bool bThrottle = bUseSignificance && GetNetMode() == NM_Standalone;
+	const APlayerCameraManager* camera = bThrottle ? UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0) : nullptr;
+
+	// Without a camera, every tween is updated every frame.
+	bHasView = camera != nullptr;
+
+	if (bHasView) {
+		viewLocation = camera->GetCameraLocation();
+		viewDirection = camera->GetCameraRotation().Vector();
+
+		// Horizontal field of view, wider than the vertical one.
+		viewCosHalfAngle = FMath::Cos(FMath::DegreesToRadians(FMath::Min(camera->GetFOVAngle() * 0.5f + ViewAngleMargin, 180.0f)));
+	}
+}
+
+ETweenSignificance ATransformableManager::GetSignificance(const ATransformable* transformable) const
+{
+	if (!bHasView) {
+		return ETweenSignificance::Full;
+	}
+
+	const FBoxSphereBounds& bounds = transformable->GetRootComponent()->Bounds;
+	const FVector toBounds = bounds.Origin - viewLocation;
+	const float distance = FMath::Max(toBounds.Size() - bounds.SphereRadius, 0.0f);
+
+	if (distance <= fullRateDistance) {
+		return ETweenSignificance::Full;
+	}
+
+	// Approximate sphere and cone test, the radius widens the cone.
+	const bool bInView = FVector::DotProduct(toBounds, viewDirection) >= toBounds.Size() * viewCosHalfAngle - bounds.SphereRadius
+		|| transformable->WasRecentlyRendered(renderedTolerance);
+
+	if (!bInView) {
+		return ETweenSignificance::Completion;
+	}
+
+	return distance <= reducedRateDistance ? ETweenSignificance::Full : ETweenSignificance::Reduced;
+}
+
+void ATransformableManager::MarkDirty(ATransformable* transformable, const AActor* instigator)
+{
+	const TWeakObjectPtr<const AActor> key(instigator);
+
+	if (transformable->dirtyInstigators.Contains(key)) {
+		return;
+	}
+
+	FTransformableSnapshot snapshot;
+	transformable->CaptureSnapshot(snapshot);
+
+	transformable->dirtyInstigators.Add(key);
+	dirtyTransformables.Add(transformable);
+	dirtyInstigators.Add(key);
+	dirtySnapshots.Add(snapshot);
+
+	WORKSHOPUE_SET_COUNTER(DirtyTransformables, dirtyTransformables.Num());
+}
+
+void ATransformableManager::CommitBaseline(const AActor* instigator)
+{
+	const TWeakObjectPtr<const AActor> key(instigator);
+
+	// The changes of destroyed instigators are never restored, they go with it.
+	for (int i = dirtyTransformables.Num() - 1; i >= 0; i--)
+	{
+		if (dirtyInstigators[i] == key || dirtyInstigators[i].IsStale()) {
+			RemoveDirty(i);
+		}
+	}
+
+	FinishRestores();
+
+	WORKSHOPUE_SET_COUNTER(DirtyTransformables, dirtyTransformables.Num());
+}
+
+void ATransformableManager::RemoveDirty(int index)
+{
+	ATransformable* transformable = dirtyTransformables[index].Get();
+	if (transformable != nullptr) {
+		transformable->dirtyInstigators.RemoveSingleSwap(dirtyInstigators[index]);
+	}
+
+	// Keep the order, the last marked are restored first.
+	dirtyTransformables.RemoveAt(index, 1, false);
+	dirtyInstigators.RemoveAt(index, 1, false);
+	dirtySnapshots.RemoveAt(index, 1, false);
+}
+
+bool ATransformableManager::IsRestoring(const AActor* instigator) const
+{
+	const TWeakObjectPtr<const AActor> key(instigator);
+
+	return pendingRestores.ContainsByPredicate([&](const FPendingRestore& restore) { return restore.instigator == key; });
+}
+
+void ATransformableManager::FinishRestores()
+{
+	for (int i = pendingRestores.Num() - 1; i >= 0; i--)
+	{
+		const TWeakObjectPtr<const AActor> instigator = pendingRestores[i].instigator;
+
+		if (!HasDirty(instigator)) {
+			pendingRestores.RemoveAt(i, 1, false);
+			OnRestoreDone.Broadcast(instigator.Get());
+		}
+	}
+}
+
+void ATransformableManager::RestoreBaseline(const AActor* instigator, int maxPerFrame)
+{
+	const TWeakObjectPtr<const AActor> key(instigator);
+
+	pendingRestores.RemoveAll([&](const FPendingRestore& restore) { return restore.instigator == key; });
+
+	if (maxPerFrame <= 0) {
+		RestoreDirty(key, MAX_int32);
+	}
+	else {
+		RestoreDirty(key, maxPerFrame);
+
+		FPendingRestore& restore = pendingRestores[pendingRestores.AddDefaulted()];
+		restore.instigator = key;
+		restore.budget = maxPerFrame;
+	}
+
+	FinishRestores();
+}
+
+void ATransformableManager::RestoreDirty(const TWeakObjectPtr<const AActor>& instigator, int count)
+{
+	for (int i = dirtyTransformables.Num() - 1; i >= 0 && count > 0; i--)
+	{
+		if (dirtyInstigators[i] != instigator) {
+			continue;
+		}
+
+		ATransformable* transformable = dirtyTransformables[i].Get();
+		const FTransformableSnapshot snapshot = dirtySnapshots[i];
+
+		RemoveDirty(i);
+		count--;
+
+		// Transformables destroyed since they were marked are skipped.
+		if (transformable != nullptr) {
+			transformable->RestoreSnapshot(snapshot);
+		}
+	}
+
+	WORKSHOPUE_SET_COUNTER(DirtyTransformables, dirtyTransformables.Num());
+}
+
+void ATransformableManager::Register(ATransformable* transformable)
+{
+	if (bKinematicTweens && transformable->gridIndex == INDEX_NONE) {
+		transformable->MakeKinematic();
+	}
+
+	grid.Add(transformable, transformable->GetComponentsBoundingBox());
+
+	WORKSHOPUE_SET_COUNTER(RegisteredTransformables, grid.Num());
+}
+
+void ATransformableManager::Unregister(ATransformable* transformable)
+{
+	StopTweens(transformable);
+	grid.Remove(transformable);
+
+	WORKSHOPUE_SET_COUNTER(RegisteredTransformables, grid.Num());
+
+	// Leave the entry of the dirty set, its weak pointer will be skipped.
+	transformable->dirtyInstigators.Reset();
+}
+
+UMaterialInstanceDynamic* ATransformableManager::GetPowerMaterial(UMaterialInterface* baseMaterial, FName colorParameter, uint32 powerMask)
+{
+	const FPowerMaterialKey key = { baseMaterial, colorParameter };
+	const int32* offset = powerMaterialOffsets.Find(key);
+
+	if (offset == nullptr) {
+		const int32 firstIndex = powerMaterials.Num();
+		const int32 maskCount = Powers::AllMask + 1;
+
+		for (int32 mask = 0; mask < maskCount; mask++)
+		{
+			UMaterialInstanceDynamic* material = UMaterialInstanceDynamic::Create(baseMaterial, this);
+			material->SetVectorParameterValue(colorParameter, FLinearColor(Powers::ToVector(Powers::GetMaskColor(mask))));
+			powerMaterials.Add(material);
+		}
+
+		offset = &powerMaterialOffsets.Add(key, firstIndex);
+	}
+
+	return powerMaterials[*offset + powerMask];
+}
+
+void ATransformableManager::StartTween(ATransformable* transformable, int powerIndex, const FSimVector& from, const FSimVector& to, float duration, double startTime)
+{
+	int& index = transformable->tweenIndices[powerIndex];
+
+	if (index == INDEX_NONE) {
+		index = tweenOwners.Add({ transformable, powerIndex });
+		tweenStartTime.AddUninitialized();
+		tweenInvDuration.AddUninitialized();
+		tweenAlpha.AddUninitialized();
+		tweenFrom.AddUninitialized();
+		tweenTo.AddUninitialized();
+		tweenValue.AddUninitialized();
+
+		WORKSHOPUE_SET_COUNTER(ActiveTweens, tweenOwners.Num());
+	}
+
+	tweenStartTime[index] = startTime;
+	tweenInvDuration[index] = 1.0f / FMath::Max(duration, SMALL_NUMBER);
+	tweenAlpha[index] = 0.0f;
+	tweenFrom[index] = FTweenVector::FromSim(from);
+	tweenTo[index] = FTweenVector::FromSim(to);
+	tweenValue[index] = tweenFrom[index];
+}
+
+void ATransformableManager::StopTween(ATransformable* transformable, int powerIndex)
+{
+	const int index = transformable->tweenIndices[powerIndex];
+
+	if (index != INDEX_NONE) {
+		RemoveAt(index);
+	}
+}
+
+void ATransformableManager::StopTweens(ATransformable* transformable)
+{
+	for (int powerIndex = 0; powerIndex < Powers::Count; powerIndex++)
+	{
+		StopTween(transformable, powerIndex);
+	}
+}
+
+void ATransformableManager::RemoveAt(int index)
+{
+	const FTweenOwner& removed = tweenOwners[index];
+	removed.transformable->tweenIndices[removed.powerIndex] = INDEX_NONE;
+
+	tweenOwners.RemoveAtSwap(index, 1, false);
+	tweenStartTime.RemoveAtSwap(index, 1, false);
+	tweenInvDuration.RemoveAtSwap(index, 1, false);
+	tweenAlpha.RemoveAtSwap(index, 1, false);
+	tweenFrom.RemoveAtSwap(index, 1, false);
+	tweenTo.RemoveAtSwap(index, 1, false);
+	tweenValue.RemoveAtSwap(index, 1, false);
+
+	WORKSHOPUE_SET_COUNTER(ActiveTweens, tweenOwners.Num());
+
+	// Fix the index of the tween moved in the hole.
+	if (index < tweenOwners.Num()) {
+		const FTweenOwner& moved = tweenOwners[index];
+		moved.transformable->tweenIndices[moved.powerIndex] = index;
+	}
+}
@@ -0,0 +1,315 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "TransformableGrid.h"
+#include "PowerTable.h"
+#include "Simulation/TransformablePowers.h"
+#include "Simulation/TweenKernel.h"
+#include "TransformableManager.generated.h"
+
+class ATransformable;
+class ANetRegionVolume;
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+
+/* Update rate of the tweens of a transformable. */
+enum class ETweenSignificance : uint8
+{
+	/* Updated every frame. */
+	Full,
+	/* Updated every reducedRateInterval frames. */
+	Reduced,
+	/* Only updated when finished. */
+	Completion
+};
+
+/*
+ * World-level manager of the transformables.
+ * Spawned with the default settings on first use, a level changes its settings by placing its own manager.
+ * Idle transformables never tick, the active tweens are stored as contiguous arrays
+ * and evaluated together by TweenKernel.
+ * Every transformable is also registered in a spatial grid kept up to date as they move.
+ * The transform of a transformable is written once per frame, whatever the number of channels tweening.
+ * Levels can opt in to kinematic transformables with bKinematicTweens, physics then carries what rests on them.
+ * Render only tweens (scale by default) leave the physics bodies behind while in flight and commit them at a capped rate.
+ * Power colors are shared material instances, one per base material and per power mask.
+ *
+ * Significance: in a standalone game, tweens of transformables far from the camera or out of view don't write their transform every frame.
+ * Tweens are evaluated from their start time and the tween clock, so they still end at the right time
+ * and any of them can be evaluated on demand with EvaluateTween. They go back to full rate as soon as they are close or in view.
+ *
+ * Checkpoints: the first time a character changes a transformable after its baseline, the state is recorded and
+ * added to the dirty set with the character. A character restores only its own changes, the other players keep
+ * the powers they took, and the restore can be spread over several frames.
+ *
+ * Rewind: a server with remote players records the recent transforms of the moving transformables,
+ * the shots of the clients are traced against the transformables as they were when the client fired.
+ */
+UCLASS()
+class WORKSHOPUE_API ATransformableManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ATransformableManager();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	/* Find the manager of the world, spawn it if it doesn't exist yet. */
+	static ATransformableManager* Get(UWorld* world);
+
+	/*
+	 * Start a tween of a transformable power value at a time of the tween clock, restart it if this power is already tweening.
+	 * Values are packed as described in Simulation/PowerRules.h.
+	 */
+	void StartTween(ATransformable* transformable, int powerIndex, const FSimVector& from, const FSimVector& to, float duration, double startTime);
+
+	/* Stop the tween of a transformable power without applying it. */
+	void StopTween(ATransformable* transformable, int powerIndex);
+
+	/* Stop every tween of a transformable. */
+	void StopTweens(ATransformable* transformable);
+
+	int GetActiveCount() const { return tweenOwners.Num(); }
+
+	/* Clock of the tweens, the time of the world in seconds accumulated in double precision. */
+	double GetTweenTime() const;
+
+	/* Tween clock of the server, estimated from the game state on clients. */
+	double GetServerTime() const;
+
+	/*
+	 * Value of the tween of a transformable power at a time of the tween clock, without updating it.
+	 * Return false if this power isn't tweening.
+	 */
+	bool EvaluateTween(const ATransformable* transformable, int powerIndex, double time, FSimVector& value) const;
+
+	/* Add a transformable to the spatial grid, or update its bounds if already registered. */
+	void Register(ATransformable* transformable);
+
+	/* Remove a transformable from the spatial grid and stop its tweens. */
+	void Unregister(ATransformable* transformable);
+
+	/* Spatial grid of the registered transformables, for aim and proximity queries. */
+	const FTransformableGrid& GetGrid() const { return grid; }
+
+	/*
+	 * Record the state of a transformable before the first change of an instigator since its baseline.
+	 * The instigator is the character changing the transformable, each character only restores its own changes.
+	 */
+	void MarkDirty(ATransformable* transformable, const AActor* instigator);
+
+	/* Forget the transformables changed by an instigator, their current state becomes its baseline. */
+	void CommitBaseline(const AActor* instigator);
+
+	/*
+	 * Restore the transformables changed by an instigator to the state before its first change of each.
+	 * With maxPerFrame > 0 at most maxPerFrame transformables are restored each frame, starting now.
+	 */
+	void RestoreBaseline(const AActor* instigator, int maxPerFrame = 0);
+
+	int GetDirtyCount() const { return dirtyTransformables.Num(); }
+
+	/* True while a restore of an instigator spread over several frames is pending. */
+	bool IsRestoring(const AActor* instigator) const;
+
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnRestoreDone, const AActor* /* instigator */);
+
+	/* Broadcast when a restore spread over several frames is done, or abandoned by CommitBaseline. */
+	FOnRestoreDone OnRestoreDone;
+
+	/* True if the transformables record their transform history, on a server with remote players. */
+	bool IsRecordingHistory() const;
+
+	/* Time of a shot of a client, clamped to the rewind window. */
+	double ClampRewindTime(double time) const;
+
+	/*
+	 * Nearest transformable crossed by a segment at a past time of the tween clock, nullptr if none.
+	 * Candidates are found from their current bounds in the grid.
+	 */
+	ATransformable* RewindLineTrace(const FVector& start, const FVector& end, double time, FHitResult& outHit) const;
+
+	/*
+	 * True if the world geometry blocks the visibility of a segment now, transformables are ignored.
+	 * Checks that a rewound hit isn't behind a wall.
+	 */
+	bool IsSegmentOccluded(const FVector& start, const FVector& end, const AActor* ignoredActor) const;
+
+	/*
+	 * Region a viewer of the net relevancy is in, null if none.
+	 * Found once per viewer and per frame, the relevancy of every transformable is checked against it.
+	 */
+	const ANetRegionVolume* GetViewerRegion(const AActor* viewer, const FVector& viewLocation);
+
+	/** Longest rewind of the shots of the clients, in seconds, 0 to trust the current transforms. */
+	UPROPERTY(EditAnywhere, Category = Replication)
+	float maxRewindTime;
+
+	/** Samples in the transform history of each moving transformable, should cover maxRewindTime at the lowest frame rate. */
+	UPROPERTY(EditAnywhere, Category = Replication)
+	int historyCapacity;
+
+	/** Move the physics bodies of the tweening transformables without velocity. */
+	UPROPERTY(EditAnywhere, Category = Tweens)
+	bool bTeleportTweens;
+
+	/**
+	 * Drive the transformables as kinematic bodies: location and rotation tweens set a kinematic target every frame,
+	 * interpolated over the physics substeps, so what rests on a transformable is carried instead of pushed out.
+	 * Overrides bTeleportTweens, bRenderOnlyLocationTweens and bRenderOnlyRotationTweens.
+	 * Stops the physics simulation of the transformables when they register, off by default.
+	 */
+	UPROPERTY(EditAnywhere, Category = Tweens)
+	bool bKinematicTweens;
+
+	/** Update the overlaps of the transformables at each tween update, otherwise only when their tweens end. */
+	UPROPERTY(EditAnywhere, Category = Tweens)
+	bool bUpdateOverlapsWhileTweening;
+
+	/**
+	 * While a location tween is in flight, only move the render transform.
+	 * The collision is committed at collisionCommitRate and when the tween ends.
+	 */
+	UPROPERTY(EditAnywhere, Category = Tweens)
+	bool bRenderOnlyLocationTweens;
+
+	/** While a rotation tween is in flight, only move the render transform. */
+	UPROPERTY(EditAnywhere, Category = Tweens)
+	bool bRenderOnlyRotationTweens;
+
+	/** While a scale tween is in flight, only scale the render transform, rescaling the collision shapes is expensive. */
+	UPROPERTY(EditAnywhere, Category = Tweens)
+	bool bRenderOnlyScaleTweens;
+
+	/** Collision commits per second of the render only tweens, 0 to only commit when they end. */
+	UPROPERTY(EditAnywhere, Category = Tweens)
+	float collisionCommitRate;
+
+	/* Update rate of the tweens of a transformable, from the camera of the first player. */
+	ETweenSignificance GetSignificance(const ATransformable* transformable) const;
+
+	/** Reduce the update rate of the tweens far from the camera or out of view, in a standalone game only. */
+	UPROPERTY(EditAnywhere, Category = Significance)
+	bool bUseSignificance;
+
+	/** Tweens closer to the camera are always updated every frame. */
+	UPROPERTY(EditAnywhere, Category = Significance)
+	float fullRateDistance;
+
+	/** Tweens in view closer to the camera are updated every frame, further ones at the reduced rate. */
+	UPROPERTY(EditAnywhere, Category = Significance)
+	float reducedRateDistance;
+
+	/** Frames between two updates of a tween at the reduced rate. */
+	UPROPERTY(EditAnywhere, Category = Significance)
+	int reducedRateInterval;
+
+	/** Transformables rendered within this time, in seconds, are in view. */
+	UPROPERTY(EditAnywhere, Category = Significance)
+	float renderedTolerance;
+
+	/*
+	 * Shared instance of a material colored for a power mask.
+	 * The instances are created on first use of a material with a color parameter.
+	 */
+	UMaterialInstanceDynamic* GetPowerMaterial(UMaterialInterface* baseMaterial, FName colorParameter, uint32 powerMask);
+
+private:
+	struct FTweenOwner
+	{
+		ATransformable* transformable;
+		int powerIndex;
+	};
+
+	// Active tweens, one entry per array and per tween.
+	TArray<FTweenOwner> tweenOwners;
+	TArray<double> tweenStartTime;
+	TArray<float> tweenInvDuration;
+	TArray<float> tweenAlpha;
+	TArray<FTweenVector, TAlignedHeapAllocator<16>> tweenFrom;
+	TArray<FTweenVector, TAlignedHeapAllocator<16>> tweenTo;
+	TArray<FTweenVector, TAlignedHeapAllocator<16>> tweenValue;
+
+	/* Transformables with tween values to write this frame, reused every frame. */
+	TArray<ATransformable*> pendingTransforms;
+
+	FTransformableGrid grid;
+
+	// Dirty set, transformables changed since the baseline of an instigator with their state before its first change.
+	TArray<TWeakObjectPtr<ATransformable>> dirtyTransformables;
+	TArray<TWeakObjectPtr<const AActor>> dirtyInstigators;
+	TArray<FTransformableSnapshot> dirtySnapshots;
+
+	/* Restore spread over several frames. */
+	struct FPendingRestore
+	{
+		TWeakObjectPtr<const AActor> instigator;
+
+		/* Transformables restored per frame. */
+		int budget;
+	};
+
+	TArray<FPendingRestore> pendingRestores;
+
+	/* Restore up to count transformables changed by an instigator, the last marked first. */
+	void RestoreDirty(const TWeakObjectPtr<const AActor>& instigator, int count);
+
+	/* Remove an entry of the dirty set. */
+	void RemoveDirty(int index);
+
+	bool HasDirty(const TWeakObjectPtr<const AActor>& instigator) const { return dirtyInstigators.Contains(instigator); }
+
+	/* End the pending restores with nothing left to restore and notify the listeners. */
+	void FinishRestores();
+
+
+	// Camera of the first player, updated once per frame.
+	bool bHasView;
+	FVector viewLocation;
+	FVector viewDirection;
+	float viewCosHalfAngle;
+
+	// Regions of the viewers of the net relevancy, found during viewerRegionsFrame.
+	TMap<const AActor*, const ANetRegionVolume*> viewerRegions;
+	uint64 viewerRegionsFrame;
+
+	// Tween clock, advanced once per frame by the first of the tick of the manager or a query.
+	mutable double tweenClock;
+	mutable uint64 tweenClockFrame;
+	mutable bool bTweenClockStarted;
+
+	void AdvanceTweenClock() const;
+
+	/* Staggers the updates of the tweens at the reduced rate. */
+	uint32 frameIndex;
+
+	void UpdateView();
+
+	/* Powers whose tweens only move the render transform while in flight. */
+	uint32 GetRenderOnlyMask() const;
+
+	/* Power materials, one entry per power mask and per base material and color parameter. */
+	UPROPERTY()
+	TArray<UMaterialInstanceDynamic*> powerMaterials;
+
+	struct FPowerMaterialKey
+	{
+		UMaterialInterface* baseMaterial;
+		FName colorParameter;
+
+		bool operator==(const FPowerMaterialKey& other) const { return baseMaterial == other.baseMaterial && colorParameter == other.colorParameter; }
+
+		friend uint32 GetTypeHash(const FPowerMaterialKey& key) { return HashCombine(GetTypeHash(key.baseMaterial), GetTypeHash(key.colorParameter)); }
+	};
+
+	/* First index in powerMaterials of each base material and color parameter. */
+	TMap<FPowerMaterialKey, int32> powerMaterialOffsets;
+
+	void RemoveAt(int index);
+};
@@ -1,7 +1,33 @@
 // Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
 
 #include "WorkshopUE.h"
+#include "WorkshopUEStats.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, WorkshopUE, "WorkshopUE" );
- 
\ No newline at end of file
+class FWorkshopUEModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		// -WorkshopCsv[=<file>] captures the stats of the whole run.
+		FString csvFile;
+		if (FParse::Value(FCommandLine::Get(), TEXT("WorkshopCsv="), csvFile) || FParse::Param(FCommandLine::Get(), TEXT("WorkshopCsv"))) {
+			FWorkshopUECsvProfiler::Get().BeginCapture(csvFile);
+		}
+
+		processStats = MakeUnique<FWorkshopUEProcessStats>();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		processStats.Reset();
+		FWorkshopUECsvProfiler::Get().EndCapture();
+	}
+
+private:
+	TUniquePtr<FWorkshopUEProcessStats> processStats;
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FWorkshopUEModule, WorkshopUE, "WorkshopUE" );
+
+DEFINE_LOG_CATEGORY(LogWorkshopUE);
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorkshopUEBot.h"
+#include "WorkshopUE.h"
+#include "WorkshopUECharacter.h"
+#include "WorldManager.h"
+#include "Kismet/GameplayStatics.h"
+
+// Relative weights of the actions.
+static const int FireWeight = 35;
+static const int AbsorbWeight = 35;
+static const int SwitchWeight = 15;
+static const int ChangeWeight = 10;
+static const int CheckpointWeight = 5;
+
+// Sets default values
+AWorkshopUEBot::AWorkshopUEBot()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	actionInterval = 0.5f;
+	respawnInterval = 30.0f;
+	turnRate = 45.0f;
+
+	character = nullptr;
+	bSetup = false;
+	actionTimer = 0.0f;
+	respawnTimer = 0.0f;
+	moveForward = 0.0f;
+	moveRight = 0.0f;
+	turn = 0.0f;
+}
+
+AWorkshopUEBot* AWorkshopUEBot::AttachFromCommandLine(UWorld* world)
+{
+	int32 seed = 0;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("WorkshopBot="), seed) && !FParse::Param(FCommandLine::Get(), TEXT("WorkshopBot"))) {
+		return nullptr;
+	}
+
+	// Bots play on clients or listen servers.
+	if (world == nullptr || world->GetNetMode() == NM_DedicatedServer) {
+		return nullptr;
+	}
+
+	AWorkshopUEBot* bot = FindOrSpawnWorldManager<AWorkshopUEBot>(world);
+
+	if (bot != nullptr && !bot->bSetup) {
+		bot->random.Initialize(seed);
+		UE_LOG(LogWorkshopUE, Display, TEXT("Bot started, seed %d"), seed);
+	}
+	return bot;
+}
+
+bool AWorkshopUEBot::IsAllowedOnServer()
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("WorkshopBotServer"));
+}
+
+// Called every frame
+void AWorkshopUEBot::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// The pawn of a client is only known once possessed.
+	if (character == nullptr || character->IsPendingKill() || !character->IsLocallyControlled()) {
+		character = Cast<AWorkshopUECharacter>(UGameplayStatics::GetPlayerPawn(GetWorld(), 0));
+		bSetup = false;
+
+		if (character == nullptr || !character->IsLocallyControlled()) {
+			return;
+		}
+	}
+
+	if (!bSetup) {
+		character->BotSetup();
+		bSetup = true;
+	}
+
+	character->AddMovementInput(character->GetActorForwardVector(), moveForward);
+	character->AddMovementInput(character->GetActorRightVector(), moveRight);
+	character->AddControllerYawInput(turn * turnRate * DeltaTime);
+
+	actionTimer -= DeltaTime;
+	if (actionTimer <= 0.0f) {
+		actionTimer += actionInterval;
+		NextAction();
+	}
+
+	respawnTimer += DeltaTime;
+	if (respawnInterval > 0.0f && respawnTimer >= respawnInterval) {
+		respawnTimer = 0.0f;
+		character->BotCheckpoint(true);
+	}
+}
+
+void AWorkshopUEBot::NextAction()
+{
+	// Wander: new inputs held until the next action.
+	moveForward = random.FRandRange(-0.2f, 1.0f);
+	moveRight = random.FRandRange(-0.5f, 0.5f);
+	turn = random.FRandRange(-1.0f, 1.0f);
+
+	int roll = random.RandRange(0, FireWeight + AbsorbWeight + SwitchWeight + ChangeWeight + CheckpointWeight - 1);
+
+	if ((roll -= FireWeight) < 0) {
+		character->OnFire();
+	}
+	else if ((roll -= AbsorbWeight) < 0) {
+		character->OnAbsorb();
+	}
+	else if ((roll -= SwitchWeight) < 0) {
+		character->SelectPower(random.RandRange(0, Powers::Count - 1));
+	}
+	else if ((roll -= ChangeWeight) < 0) {
+		character->ChangePower(random.FRand() < 0.5f ? -1.0f : 1.0f);
+	}
+	else {
+		character->BotCheckpoint(false);
+	}
+}
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "WorkshopUEBot.generated.h"
+
+class AWorkshopUECharacter;
+
+/*
+ * Headless player for the load tests, drives the locally controlled character with scripted actions:
+ * walking and turning, fire, absorb, power switches, checkpoints and respawns, drawn from a seeded random stream.
+ * Bots run in real network clients so the server pays for their connections, movement and actions like for players.
+ *
+ * Started from the command line of a client, the server must allow the bot setup with -WorkshopBotServer:
+ *	WorkshopUEServer <map> -WorkshopBotServer
+ *	WorkshopUE 127.0.0.1 -nullrhi -nosound -unattended -WorkshopBot=<seed>
+ * Scripts/BotLoadTest.py runs a server with an increasing number of bots and reports its cost.
+ */
+UCLASS(NotPlaceable, Transient)
+class WORKSHOPUE_API AWorkshopUEBot : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AWorkshopUEBot();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	/* Start the bot asked on the command line in a world, null if none is asked. */
+	static AWorkshopUEBot* AttachFromCommandLine(UWorld* world);
+
+	/* True if the server accepts the bot setup of the clients. */
+	static bool IsAllowedOnServer();
+
+	/** Seconds between two actions. */
+	UPROPERTY(EditAnywhere, Category = Bot)
+	float actionInterval;
+
+	/** Seconds between two respawns at the last checkpoint, which also reset the powers. */
+	UPROPERTY(EditAnywhere, Category = Bot)
+	float respawnInterval;
+
+	/** Turn rate while walking, in degrees per second. */
+	UPROPERTY(EditAnywhere, Category = Bot)
+	float turnRate;
+
+private:
+	UPROPERTY()
+	AWorkshopUECharacter* character;
+
+	FRandomStream random;
+
+	/* The gun of the character was equipped for the bot. */
+	bool bSetup;
+
+	float actionTimer;
+	float respawnTimer;
+
+	// Input held until the next action.
+	float moveForward;
+	float moveRight;
+	float turn;
+
+	void NextAction();
+};
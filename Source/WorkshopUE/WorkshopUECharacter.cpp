@@ -2,10 +2,14 @@
 
 #include "WorkshopUECharacter.h"
 #include "WorkshopUEProjectile.h"
+#include "TransformableManager.h"
+#include "WorkshopUEStats.h"
+#include "WorkshopUEBot.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/InputSettings.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Kismet/GameplayStatics.h"
@@ -27,6 +31,13 @@ AWorkshopUECharacter::AWorkshopUECharacter()
 	BaseLookUpRate = 45.f;
 
 	rayLength = 4000.0f;
+	respawnRestoresPerFrame = 64;
+	bCommitTransformablesOnCheckpoint = false;
+	bAsyncAbsorbTrace = false;
+	absorbDirection = FVector::ForwardVector;
+	absorbShotTime = 0.0f;
+	sessionRecorder = nullptr;
+	absorbTraceDelegate.BindUObject(this, &AWorkshopUECharacter::OnAbsorbTraceDone);
 
 	// Create a CameraComponent	
 	FirstPersonCameraComponent = CreateDefaultSubobject<UCameraComponent>(TEXT("FirstPersonCamera"));
@@ -108,6 +119,78 @@ void AWorkshopUECharacter::BeginPlay()
 	// Show or hide the two versions of the gun based on whether or not we're using motion controllers.
 
 	Arms->SetHiddenInGame(false, true);
+
+	// Move after the transformables, a transformable used as a base carries the character in the same frame.
+	ATransformableManager* manager = GetTransformableManager();
+	if (manager != nullptr) {
+		GetCharacterMovement()->AddTickPrerequisiteActor(manager);
+	}
+
+	sessionRecorder = ASessionRecorder::AttachFromCommandLine(this);
+	AWorkshopUEBot::AttachFromCommandLine(GetWorld());
+}
+
+void AWorkshopUECharacter::BotSetup()
+{
+	if (Role < ROLE_Authority) {
+		DisplayGun(true);
+		ServerBotSetup();
+		return;
+	}
+
+	EquipGun();
+
+	for (int i = 0; i < Powers::Count; i++) {
+		UnlockNewPower(i);
+	}
+}
+
+void AWorkshopUECharacter::BotCheckpoint(bool bRespawn)
+{
+	if (Role < ROLE_Authority) {
+		ServerBotCheckpoint(bRespawn);
+		return;
+	}
+
+	if (bRespawn) {
+		TeleportToLastCheckpoint();
+	}
+	else {
+		SetNewCheckpoint(GetActorLocation());
+	}
+}
+
+void AWorkshopUECharacter::ServerBotSetup_Implementation()
+{
+	BotSetup();
+}
+
+bool AWorkshopUECharacter::ServerBotSetup_Validate()
+{
+	return AWorkshopUEBot::IsAllowedOnServer();
+}
+
+void AWorkshopUECharacter::ServerBotCheckpoint_Implementation(bool bRespawn)
+{
+	BotCheckpoint(bRespawn);
+}
+
+bool AWorkshopUECharacter::ServerBotCheckpoint_Validate(bool bRespawn)
+{
+	return AWorkshopUEBot::IsAllowedOnServer();
+}
+
+bool AWorkshopUECharacter::RecordEvent(ESessionEvent type, int index, const FVector& location)
+{
+	if (sessionRecorder == nullptr) {
+		return true;
+	}
+
+	FSessionEvent event;
+	event.type = type;
+	event.index = (int8)index;
+	event.location = location;
+	return sessionRecorder->HandleEvent(event);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -151,41 +234,83 @@ void AWorkshopUECharacter::SetupPlayerInputComponent(class UInputComponent* Play
 
 void AWorkshopUECharacter::OnFire()
 {
-	if (!gunComponent->IsEnable()) {
+	WORKSHOPUE_SCOPE_CYCLE(Fire);
+
+	if (!RecordEvent(ESessionEvent::Fire)) {
 		return;
 	}
 
+	const ATransformableManager* manager = GetTransformableManager();
+
+	// The powers live on the server, the client predicts the use of the power.
+	if (Role < ROLE_Authority) {
+		const uint8 sequence = gunComponent->BeginPrediction();
+
+		if (gunComponent->IsEnable() && gunComponent->TryToUsePower()) {
+			gunComponent->RecordPrediction(sequence, gunComponent->GetCurrentPower(), false);
+		}
+
+		ServerFire(sequence, manager != nullptr ? (float)manager->GetServerTime() : 0.0f);
+		return;
+	}
+
+	Fire(manager != nullptr ? manager->GetTweenTime() : 0.0);
+}
+
+bool AWorkshopUECharacter::Fire(double shotTime)
+{
+	if (!gunComponent->IsEnable()) {
+		return false;
+	}
+
 	// Check projectile classe
-	if (gunComponent->ProjectileClasses[gunComponent->currentPower] == NULL)
+	if (gunComponent->ProjectileClasses[gunComponent->GetCurrentPower()] == NULL)
 	{
-		return; // TODO debug for all ?
+		return false; // TODO debug for all ?
 	}
 
 	// Check world
 	UWorld* const World = GetWorld();
 	if (World == NULL)
 	{
-		return;
+		return false;
 	}
 
 	// Check if gun can fire his power.
 	if (gunComponent->TryToUsePower()) {
-		// Spawn projectile
+		// Fire projectile
 		{
 			const FRotator SpawnRotation = GetControlRotation();
 			// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
 			const FVector SpawnLocation = shootOrigin->GetComponentToWorld().GetLocation();
 
-			// Set Spawn Collision Handling Override
-			FActorSpawnParameters ActorSpawnParams;
-			ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-
-			// Spawn the projectile at the muzzle
-			AWorkshopUEProjectile* projectile = World->SpawnActor<AWorkshopUEProjectile>(gunComponent->ProjectileClasses[gunComponent->currentPower], SpawnLocation, SpawnRotation, ActorSpawnParams);
+			// Launch a pooled projectile from the muzzle
+			AWorkshopUEProjectile* projectile = gunComponent->AcquireProjectile(gunComponent->GetCurrentPower());
 			
 			if (projectile) {
 				projectile->gunComponent = gunComponent;
 				projectile->player = this;
+
+				// A remote shot left the muzzle earlier, the flight it had since is traced against the rewound transformables.
+				const ATransformableManager* manager = GetTransformableManager();
+				const double flightTime = manager != nullptr ? manager->GetTweenTime() - manager->ClampRewindTime(shotTime) : 0.0;
+
+				FHitResult Hit;
+				ATransformable* t = nullptr;
+
+				if (flightTime > 0.0) {
+					const FVector flightEnd = SpawnLocation + SpawnRotation.Vector() * projectile->GetProjectileMovement()->InitialSpeed * flightTime;
+					t = manager->RewindLineTrace(SpawnLocation, flightEnd, manager->ClampRewindTime(shotTime), Hit);
+
+					// The level doesn't move, a rewound hit behind a wall is rejected.
+					if (t != nullptr && manager->IsSegmentOccluded(SpawnLocation, Hit.ImpactPoint, this)) {
+						t = nullptr;
+					}
+				}
+
+				if (t == nullptr || !projectile->HandleImpact(t, Hit.GetComponent())) {
+					projectile->Launch(SpawnLocation, SpawnRotation, gunComponent->bBatchProjectileSimulation);
+				}
 			}
 		}
 
@@ -205,11 +330,56 @@ void AWorkshopUECharacter::OnFire()
 				AnimInstance->Montage_Play(FireAnimation, 1.f);
 			}
 		}
+
+		return true;
 	}
+
+	return false;
 }
 
 void AWorkshopUECharacter::OnAbsorb()
 {
+	WORKSHOPUE_SCOPE_CYCLE(Absorb);
+
+	if (!RecordEvent(ESessionEvent::Absorb)) {
+		return;
+	}
+
+	if (Role < ROLE_Authority) {
+		// The client traces against the transformables it sees, the server checks the hit against their history.
+		if (Controller) {
+			const FVector StartTrace = shootOrigin->GetComponentToWorld().GetLocation();
+			const FVector Direction = FirstPersonCameraComponent->GetForwardVector();
+			const FVector EndTrace = StartTrace + Direction * rayLength;
+
+			const ATransformableManager* manager = GetTransformableManager();
+			const float shotTime = manager != nullptr ? (float)manager->GetServerTime() : 0.0f;
+
+			FCollisionQueryParams TraceParams;
+			TraceParams.AddIgnoredActor(this);
+
+			if (bAsyncAbsorbTrace) {
+				// The aim and the time are those of the input, the prediction and the request wait for the trace.
+				if (!GetWorld()->IsTraceHandleValid(absorbTraceHandle, false)) {
+					absorbDirection = Direction;
+					absorbShotTime = shotTime;
+					absorbTraceHandle = GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, StartTrace, EndTrace, ECollisionChannel::ECC_Visibility,
+						TraceParams, FCollisionResponseParams::DefaultResponseParam, &absorbTraceDelegate, gunComponent->GetCurrentPower());
+				}
+				return;
+			}
+
+			FHitResult Hit;
+			ATransformable* t = nullptr;
+			if (GetWorld()->LineTraceSingleByChannel(Hit, StartTrace, EndTrace, ECollisionChannel::ECC_Visibility, TraceParams)) {
+				t = Cast<ATransformable>(Hit.GetActor());
+			}
+
+			PredictAbsorb(t, Direction, shotTime);
+		}
+		return;
+	}
+
 	if (!gunComponent->IsEnable()) {
 		return;
 	}
@@ -217,52 +387,179 @@ void AWorkshopUECharacter::OnAbsorb()
 	// Check if can absorb the power on targeted transformable
 
 	// Raycast
-	if (Controller && Controller->IsLocalPlayerController()) {
+	if (Controller) {
 
 		const FVector StartTrace = shootOrigin->GetComponentToWorld().GetLocation(); // trace start is the camera location
-		const FVector Direction = FirstPersonCameraComponent->GetForwardVector();
+		// The camera of a remote player is not updated on the server, aim with its control rotation.
+		const FVector Direction = IsLocallyControlled() ? FirstPersonCameraComponent->GetForwardVector() : GetControlRotation().Vector();
 		const FVector EndTrace = StartTrace + Direction * rayLength; // and trace end is the camera location + an offset in the direction you are looking, the 200 is the distance at wich it checks
 
 		FCollisionQueryParams TraceParams;
 		TraceParams.AddIgnoredActor(this);
 
+		if (bAsyncAbsorbTrace) {
+			// Only one absorb trace in flight, the result is applied next frame.
+			if (!GetWorld()->IsTraceHandleValid(absorbTraceHandle, false)) {
+				absorbTraceHandle = GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, StartTrace, EndTrace, ECollisionChannel::ECC_Visibility,
+					TraceParams, FCollisionResponseParams::DefaultResponseParam, &absorbTraceDelegate, gunComponent->GetCurrentPower());
+			}
+			return;
+		}
+
 		FHitResult Hit;
 		if (GetWorld()->LineTraceSingleByChannel(Hit, StartTrace, EndTrace, ECollisionChannel::ECC_Visibility, TraceParams)) {
+			ApplyAbsorbHit(Hit, StartTrace, EndTrace);
+		}
+	}
+}
 
-			ATransformable* t = Cast<ATransformable>(Hit.GetActor());
+void AWorkshopUECharacter::ServerFire_Implementation(uint8 sequence, float shotTime)
+{
+	WORKSHOPUE_SCOPE_CYCLE(Fire);
 
-			// Minimal Feedback !
-			UKismetSystemLibrary::DrawDebugLine(GetWorld(), StartTrace, EndTrace, FColor::Red, 0.2f, 2.0f);
+	const bool bFired = RecordEvent(ESessionEvent::Fire) && Fire(shotTime);
+	gunComponent->AcknowledgePrediction(sequence, bFired);
+}
 
-			// try and play a firing animation if specified
-			if (FireAnimation != NULL)
-			{
-				// Get the animation object for the arms mesh
-				UAnimInstance* AnimInstance = Arms->GetAnimInstance();
-				if (AnimInstance != NULL)
-				{
-					AnimInstance->Montage_Play(FireAnimation, 1.f);
-				}
+bool AWorkshopUECharacter::ServerFire_Validate(uint8 sequence, float shotTime)
+{
+	return true;
+}
+
+void AWorkshopUECharacter::ServerAbsorb_Implementation(uint8 sequence, ATransformable* target, FVector_NetQuantizeNormal direction, float shotTime)
+{
+	WORKSHOPUE_SCOPE_CYCLE(Absorb);
+
+	bool bAbsorbed = false;
+
+	if (RecordEvent(ESessionEvent::Absorb) && gunComponent->IsEnable()) {
+		// The ray starts from the muzzle of the server, only the aim of the client is trusted.
+		const FVector StartTrace = shootOrigin->GetComponentToWorld().GetLocation();
+		const FVector EndTrace = StartTrace + direction * rayLength;
+
+		const ATransformableManager* manager = GetTransformableManager();
+
+		FHitResult Hit;
+		if (target != nullptr && manager != nullptr && target->RewindLineTrace(Hit, StartTrace, EndTrace, manager->ClampRewindTime(shotTime))
+			&& !manager->IsSegmentOccluded(StartTrace, Hit.ImpactPoint, this)) {
+			bAbsorbed = ApplyAbsorbHit(Hit, StartTrace, EndTrace);
+		}
+	}
+
+	gunComponent->AcknowledgePrediction(sequence, bAbsorbed);
+}
+
+bool AWorkshopUECharacter::ServerAbsorb_Validate(uint8 sequence, ATransformable* target, FVector_NetQuantizeNormal direction, float shotTime)
+{
+	return direction.IsNormalized();
+}
+
+void AWorkshopUECharacter::ServerSelectPower_Implementation(int8 index)
+{
+	SelectPower(index);
+}
+
+bool AWorkshopUECharacter::ServerSelectPower_Validate(int8 index)
+{
+	return Powers::IsValid(index);
+}
+
+void AWorkshopUECharacter::ServerChangePower_Implementation(int8 direction)
+{
+	ChangePower(direction);
+}
+
+bool AWorkshopUECharacter::ServerChangePower_Validate(int8 direction)
+{
+	return direction == -1 || direction == 1;
+}
+
+void AWorkshopUECharacter::OnAbsorbTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceData)
+{
+	WORKSHOPUE_SCOPE_CYCLE(Absorb);
+
+	absorbTraceHandle = FTraceHandle();
+
+	// The gun may have been disabled or switched to another power since the trace was issued.
+	if (!gunComponent->IsEnable() || gunComponent->GetCurrentPower() != (int)TraceData.UserData) {
+		return;
+	}
+
+	if (Role < ROLE_Authority) {
+		ATransformable* t = nullptr;
+		for (const FHitResult& Hit : TraceData.OutHits)
+		{
+			if (Hit.bBlockingHit) {
+				t = Cast<ATransformable>(Hit.GetActor());
+				break;
 			}
+		}
 
-			if (t != NULL) {
-				if (t->CheckPowerPresent(gunComponent->currentPower)) {
+		PredictAbsorb(t, absorbDirection, absorbShotTime);
+		return;
+	}
 
-					t->PutPowerEffect(gunComponent->currentPower, gunComponent);
+	for (const FHitResult& Hit : TraceData.OutHits)
+	{
+		if (Hit.bBlockingHit) {
+			ApplyAbsorbHit(Hit, TraceData.Start, TraceData.End);
+			return;
+		}
+	}
+}
 
-					gunComponent->AbsorbPower();
+void AWorkshopUECharacter::PredictAbsorb(ATransformable* t, const FVector& direction, float shotTime)
+{
+	// The absorb is predicted, the transformable tweens back if the server rejects it.
+	const uint8 sequence = gunComponent->BeginPrediction();
+	const int power = gunComponent->GetCurrentPower();
+
+	if (t != nullptr && gunComponent->IsEnable() && t->CheckPowerPresent(power)) {
+		t->PredictPowerEffect(power, gunComponent);
+		gunComponent->AbsorbPower();
+		gunComponent->RecordPrediction(sequence, power, true, t);
+	}
 
-					AddTransformable(t);
+	ServerAbsorb(sequence, t, direction, shotTime);
+}
 
-					// try and play the sound if specified
-					if (AbsorbSound != NULL)
-					{
-						UGameplayStatics::PlaySoundAtLocation(this, AbsorbSound, GetActorLocation());
-					}
-				}
+bool AWorkshopUECharacter::ApplyAbsorbHit(const FHitResult& Hit, const FVector& StartTrace, const FVector& EndTrace)
+{
+	// The hit actor is weakly referenced, null if it has been destroyed since the trace.
+	ATransformable* t = Cast<ATransformable>(Hit.GetActor());
+
+	// Minimal Feedback !
+	UKismetSystemLibrary::DrawDebugLine(GetWorld(), StartTrace, EndTrace, FColor::Red, 0.2f, 2.0f);
+
+	// try and play a firing animation if specified
+	if (FireAnimation != NULL)
+	{
+		// Get the animation object for the arms mesh
+		UAnimInstance* AnimInstance = Arms->GetAnimInstance();
+		if (AnimInstance != NULL)
+		{
+			AnimInstance->Montage_Play(FireAnimation, 1.f);
+		}
+	}
+
+	if (t != NULL && !t->IsPendingKill()) {
+		if (t->CheckPowerPresent(gunComponent->GetCurrentPower())) {
+
+			t->PutPowerEffect(gunComponent->GetCurrentPower(), gunComponent);
+
+			gunComponent->AbsorbPower();
+
+			// try and play the sound if specified
+			if (AbsorbSound != NULL)
+			{
+				UGameplayStatics::PlaySoundAtLocation(this, AbsorbSound, GetActorLocation());
 			}
+
+			return true;
 		}
 	}
+
+	return false;
 }
 
 void AWorkshopUECharacter::BeginTouch(const ETouchIndex::Type FingerIndex, const FVector Location)
@@ -290,14 +587,23 @@ void AWorkshopUECharacter::EndTouch(const ETouchIndex::Type FingerIndex, const F
 	TouchItem.bIsPressed = false;
 }
 
-void AWorkshopUECharacter::ResetTransformables()
+ATransformableManager* AWorkshopUECharacter::GetTransformableManager()
 {
-	for (int i = 0; i < transformablesUsed.Num(); i++)
-	{
-		transformablesUsed[i]->Reset();
+	if (!transformableManager.IsValid()) {
+		transformableManager = ATransformableManager::Get(GetWorld());
 	}
+	return transformableManager.Get();
+}
 
-	transformablesUsed.Reset();
+void AWorkshopUECharacter::ResetTransformables(int maxPerFrame)
+{
+	WORKSHOPUE_SCOPE_CYCLE(ResetTransformables);
+
+	ATransformableManager* manager = GetTransformableManager();
+
+	if (manager) {
+		manager->RestoreBaseline(this, maxPerFrame);
+	}
 }
 
 void AWorkshopUECharacter::MoveForward(float Value)
@@ -384,23 +690,46 @@ bool AWorkshopUECharacter::EnableTouchscreenMovement(class UInputComponent* Play
 //	}
 //}
 
+void AWorkshopUECharacter::SelectPower(int index)
+{
+	if (!RecordEvent(ESessionEvent::SwitchPower, index)) {
+		return;
+	}
+
+	if (Role < ROLE_Authority) {
+		ServerSelectPower((int8)index);
+		return;
+	}
+
+	gunComponent->SwitchToPower(index);
+}
+
 void AWorkshopUECharacter::SwitchToPower1()
 {
-	gunComponent->SwitchToPower(0);
+	SelectPower(0);
 }
 
 void AWorkshopUECharacter::SwitchToPower2()
 {
-	gunComponent->SwitchToPower(1);
+	SelectPower(1);
 }
 
 void AWorkshopUECharacter::SwitchToPower3()
 {
-	gunComponent->SwitchToPower(2);
+	SelectPower(2);
 }
 
 void AWorkshopUECharacter::ChangePower(float value)
 {
+	if (value == 0 || !RecordEvent(ESessionEvent::ChangePower, value < 0 ? -1 : 1)) {
+		return;
+	}
+
+	if (Role < ROLE_Authority) {
+		ServerChangePower(value < 0 ? -1 : 1);
+		return;
+	}
+
 	if (value < 0) {
 		gunComponent->PreviousPower();
 	}
@@ -418,18 +747,38 @@ void AWorkshopUECharacter::DisplayGun(bool displayed)
 
 void AWorkshopUECharacter::EquipGun()
 {
+	if (!RecordEvent(ESessionEvent::EquipGun)) {
+		return;
+	}
+
 	DisplayGun(true);
 
-	gunComponent->EquipGun();
+	// Level events happen on every machine, the powers only change on the server.
+	if (HasAuthority()) {
+		gunComponent->EquipGun();
+	}
 }
 
 void AWorkshopUECharacter::UnlockNewPower(int index)
 {
-	gunComponent->UnlockPower(index);
+	if (!RecordEvent(ESessionEvent::UnlockPower, index)) {
+		return;
+	}
+
+	if (HasAuthority()) {
+		gunComponent->UnlockPower(index);
+	}
 }
 
 void AWorkshopUECharacter::KillPlayer() {
-	gunComponent->bEquipped = false;
+	if (!RecordEvent(ESessionEvent::Kill)) {
+		return;
+	}
+
+	if (HasAuthority()) {
+		CancelEquipWhenRestored();
+		gunComponent->SetEquipped(false);
+	}
 
 	FirstPersonCameraComponent->PostProcessSettings.SceneColorTint = FColor::Orange;
 
@@ -437,36 +786,108 @@ void AWorkshopUECharacter::KillPlayer() {
 }
 
 void AWorkshopUECharacter::SetNewCheckpoint(FVector newCheckpoint) {
+	if (!RecordEvent(ESessionEvent::Checkpoint, 0, newCheckpoint)) {
+		return;
+	}
 
 	lastCheckpoint = newCheckpoint;
+
+	if (bCommitTransformablesOnCheckpoint && HasAuthority()) {
+		ATransformableManager* manager = GetTransformableManager();
+
+		if (manager) {
+			manager->CommitBaseline(this);
+		}
+	}
 }
 
 void AWorkshopUECharacter::TeleportToLastCheckpoint() {
-	
-	// Reset gun powers and transformable affected.
-	PassThroughBarrer();
+	if (!RecordEvent(ESessionEvent::Teleport)) {
+		return;
+	}
+
+	// Reset gun powers and transformable affected, spread behind the respawn.
+	ResetWorldState(respawnRestoresPerFrame);
 
 	FirstPersonCameraComponent->PostProcessSettings.SceneColorTint = FColor::White;
 	GetRootComponent()->SetRelativeLocation(lastCheckpoint);
-	gunComponent->bEquipped = true;
+
+	if (HasAuthority()) {
+		EquipWhenRestored();
+	}
 }
 
 void AWorkshopUECharacter::PassThroughBarrer()
 {
-	gunComponent->bEquipped = false;
+	if (!RecordEvent(ESessionEvent::PassBarrier)) {
+		return;
+	}
+
+	ResetWorldState(0);
+}
+
+void AWorkshopUECharacter::ResetWorldState(int maxRestoresPerFrame)
+{
+	// Clients receive the reset state from the server.
+	if (!HasAuthority()) {
+		return;
+	}
+
+	CancelEquipWhenRestored();
+	gunComponent->SetEquipped(false);
 
 	// Reset transformables affected.
-	ResetTransformables();
+	ResetTransformables(maxRestoresPerFrame);
 
 	// Reset powers of the gun.
 	gunComponent->ResetPowers();
 }
 
 void AWorkshopUECharacter::ExitBarrer() {
-	gunComponent->bEquipped = true;
+	if (!RecordEvent(ESessionEvent::ExitBarrier)) {
+		return;
+	}
+
+	if (HasAuthority()) {
+		EquipWhenRestored();
+	}
+}
+
+void AWorkshopUECharacter::EquipWhenRestored()
+{
+	ATransformableManager* manager = GetTransformableManager();
+
+	if (manager == nullptr || !manager->IsRestoring(this)) {
+		gunComponent->SetEquipped(true);
+		return;
+	}
+
+	if (!restoreDoneHandle.IsValid()) {
+		restoreDoneHandle = manager->OnRestoreDone.AddUObject(this, &AWorkshopUECharacter::OnRestoreDone);
+	}
+}
+
+void AWorkshopUECharacter::OnRestoreDone(const AActor* instigator)
+{
+	// Restores of the other players.
+	if (instigator != this) {
+		return;
+	}
+
+	CancelEquipWhenRestored();
+	gunComponent->SetEquipped(true);
 }
 
-void AWorkshopUECharacter::AddTransformable(ATransformable* transformable)
+void AWorkshopUECharacter::CancelEquipWhenRestored()
 {
-	transformablesUsed.AddUnique(transformable);
+	if (!restoreDoneHandle.IsValid()) {
+		return;
+	}
+
+	ATransformableManager* manager = GetTransformableManager();
+
+	if (manager != nullptr) {
+		manager->OnRestoreDone.Remove(restoreDoneHandle);
+	}
+	restoreDoneHandle.Reset();
 }
\ No newline at end of file
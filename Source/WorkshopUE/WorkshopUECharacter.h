@@ -4,14 +4,16 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "WorldCollision.h"
 #include "GunComponent.h"
 #include "Transformable.h"
+#include "SessionRecorder.h"
 #include "WorkshopUECharacter.generated.h"
 
 class UInputComponent;
 
 UCLASS(config=Game)
-class AWorkshopUECharacter : public ACharacter
+class WORKSHOPUE_API AWorkshopUECharacter : public ACharacter
 {
 	GENERATED_BODY()
 
@@ -69,17 +71,67 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	class UGunComponent* gunComponent;
 
+	/** Transformables restored per frame when respawning at a checkpoint, 0 to restore all of them at once. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
+	int respawnRestoresPerFrame;
+
+	/** Make the current state of the transformables the reset state when reaching a checkpoint. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
+	bool bCommitTransformablesOnCheckpoint;
+
 	/** Default length of the absorb ray. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	float rayLength;
 
-protected:
-	
-	/** Fires a projectile. */
+	/** Run the absorb ray as an async trace, the absorb is applied, or predicted and sent to the server by a client, on the next frame. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
+	bool bAsyncAbsorbTrace;
+
+	/** Fires a projectile, as the fire input does. */
 	void OnFire();
 
+protected:
+
+	/** Fire from the server, shotTime is the server time the shooter fired at. Return false if the gun couldn't fire. */
+	bool Fire(double shotTime);
+
 	void OnAbsorb();
 
+	/**
+	 * Input actions of a remote client, run on the server.
+	 * Shots carry the server time estimated by the client when it fired, they are checked against the transformables
+	 * rewound to that time. The absorb ray is traced by the client, the server checks the transformable it claims.
+	 * Shots are predicted by the client, the sequence numbers the prediction acknowledged by the server.
+	 */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerFire(uint8 sequence, float shotTime);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerAbsorb(uint8 sequence, ATransformable* target, FVector_NetQuantizeNormal direction, float shotTime);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSelectPower(int8 index);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerChangePower(int8 direction);
+
+	/** Absorb the power of the transformable hit by the absorb ray, return true if a power was absorbed. */
+	bool ApplyAbsorbHit(const FHitResult& Hit, const FVector& StartTrace, const FVector& EndTrace);
+
+	/** Called when the async absorb trace is done. */
+	void OnAbsorbTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceData);
+
+	/* Predict the absorb of the transformable hit by the ray of a client, null if none, and send it to the server. */
+	void PredictAbsorb(ATransformable* t, const FVector& direction, float shotTime);
+
+	FTraceDelegate absorbTraceDelegate;
+
+	FTraceHandle absorbTraceHandle;
+
+	// Aim and server time of the absorb input of a client, while its async trace is in flight.
+	FVector absorbDirection;
+	float absorbShotTime;
+
 	/** Handles moving forward/backward */
 	void MoveForward(float Val);
 
@@ -111,12 +163,55 @@ protected:
 	//void TouchUpdate(const ETouchIndex::Type FingerIndex, const FVector Location);
 	TouchData	TouchItem;
 
-	TArray<ATransformable*> transformablesUsed;
+	/**
+	 * Restore the transformables changed by this character since its last baseline, the other players keep their changes.
+	 * @param maxPerFrame	Transformables restored per frame, 0 to restore all of them now.
+	 */
+	void ResetTransformables(int maxPerFrame);
+
+	/** Reset the transformables and the gun powers. */
+	void ResetWorldState(int maxRestoresPerFrame);
+
+	/* Equip the gun once the transformables are restored, the powers can't be used on a transformable being restored. */
+	void EquipWhenRestored();
+
+	void OnRestoreDone(const AActor* instigator);
+
+	/* Forget the pending equip of EquipWhenRestored, when the gun is unequipped again. */
+	void CancelEquipWhenRestored();
 
-	void ResetTransformables();
+	FDelegateHandle restoreDoneHandle;
 
 	FVector lastCheckpoint;
 
+	/* Manager of the transformables of the world, found on first use. */
+	class ATransformableManager* GetTransformableManager();
+
+	TWeakObjectPtr<class ATransformableManager> transformableManager;
+
+	/** Recorder of the session, null unless recording or replaying. */
+	UPROPERTY()
+	ASessionRecorder* sessionRecorder;
+
+	/** Give an event to the session recorder, return false if it must be dropped. */
+	bool RecordEvent(ESessionEvent type, int index = 0, const FVector& location = FVector::ZeroVector);
+
+	friend class ASessionRecorder;
+	friend class AWorkshopUEBot;
+
+	/* Equip the gun and unlock every power for a bot, on the server. */
+	void BotSetup();
+
+	/* Set a checkpoint where the bot stands, or respawn at the last one, on the server. */
+	void BotCheckpoint(bool bRespawn);
+
+	/** Bot actions of a remote client, only accepted by a server allowing bots. */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerBotSetup();
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerBotCheckpoint(bool bRespawn);
+
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(UInputComponent* InputComponent) override;
@@ -150,6 +245,11 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void UnlockNewPower(int index);
 
+	/**
+	Switch to a power of the gun.
+	*/
+	void SelectPower(int index);
+
 	/**
 	Switch to translate power.
 	*/
@@ -194,10 +294,5 @@ public:
 	*/
 	UFUNCTION(BlueprintCallable)
 	void ExitBarrer();
-
-
-	/** Add a transformable affected by power.
-	*/
-	void AddTransformable(ATransformable* transformable);
 };
 
@@ -1,8 +1,12 @@
 // Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
 
 #include "WorkshopUEProjectile.h"
+#include "ProjectilePool.h"
+#include "ProjectileManager.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
+#include "TimerManager.h"
+#include "WorkshopUEStats.h"
 
 AWorkshopUEProjectile::AWorkshopUEProjectile() 
 {
@@ -28,15 +32,94 @@ AWorkshopUEProjectile::AWorkshopUEProjectile()
 	ProjectileMovement->bShouldBounce = true;
 	ProjectileMovement->ProjectileGravityScale = 0.0f;
 
-	// Die after 2 seconds by default
+	// Return to the pool after 2 seconds by default
 	lifespan = 2.0f; // customizable in editor.
 
-	InitialLifeSpan = lifespan;
+	bHasHitTransformable = false;
+
+	// Spawned by the server, clients only see it move.
+	bReplicates = true;
+	bReplicateMovement = true;
+
+	gunComponent = nullptr;
+	player = nullptr;
+	pool = nullptr;
+	bInFlight = false;
+}
 
+void AWorkshopUEProjectile::Launch(const FVector& location, const FRotator& rotation, bool bSimulateInBatch)
+{
 	bHasHitTransformable = false;
+
+	if (!bInFlight) {
+		WORKSHOPUE_ADD_COUNTER(LiveProjectiles, 1);
+	}
+	bInFlight = true;
+
+	SetActorLocationAndRotation(location, rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	SetActorHiddenInGame(false);
+
+	if (bSimulateInBatch) {
+		// Movement, collision and lifespan are handled by the manager.
+		// Pooled projectiles are launched many times, the manager is only looked up once.
+		if (!projectileManager.IsValid()) {
+			projectileManager = AProjectileManager::Get(GetWorld());
+		}
+
+		AProjectileManager* manager = projectileManager.Get();
+		if (manager) {
+			manager->AddProjectile(this, location, rotation.Vector() * ProjectileMovement->InitialSpeed, lifespan);
+			return;
+		}
+	}
+
+	SetActorEnableCollision(true);
+
+	// The movement component forgets its updated component when it stops simulating.
+	ProjectileMovement->SetUpdatedComponent(CollisionComp);
+	ProjectileMovement->Velocity = rotation.Vector() * ProjectileMovement->InitialSpeed;
+	ProjectileMovement->Activate(true);
+
+	GetWorldTimerManager().SetTimer(lifespanTimer, this, &AWorkshopUEProjectile::Expire, lifespan);
+}
+
+void AWorkshopUEProjectile::Disable()
+{
+	GetWorldTimerManager().ClearTimer(lifespanTimer);
+
+	if (bInFlight) {
+		WORKSHOPUE_ADD_COUNTER(LiveProjectiles, -1);
+	}
+	bInFlight = false;
+
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+}
+
+void AWorkshopUEProjectile::ReturnToPool()
+{
+	Disable();
+
+	if (pool) {
+		pool->Release(this);
+	}
+	else {
+		Destroy();
+	}
 }
 
 void AWorkshopUEProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+{
+	// Impacts change the powers, only the server applies them.
+	if (HasAuthority()) {
+		HandleImpact(OtherActor, OtherComp);
+	}
+}
+
+bool AWorkshopUEProjectile::HandleImpact(AActor* OtherActor, UPrimitiveComponent* OtherComp)
 {
 	// Only add impulse and destroy projectile if we hit a physics
 	if ((OtherActor != NULL) && (OtherActor != this) && (OtherComp != NULL))
@@ -44,24 +127,43 @@ void AWorkshopUEProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherAct
 		ATransformable* t = Cast<ATransformable>(OtherActor);
 
 		if (t != NULL) {
-			player->AddTransformable(t);
-
-			t->PutPowerEffect(gunComponent->currentPower, gunComponent);
+			t->PutPowerEffect(gunComponent->GetCurrentPower(), gunComponent);
 
 			bHasHitTransformable = true; // Prevent to keep the power in the gun.
 
-			Destroy();
+			ReturnToPool();
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void AWorkshopUEProjectile::Expire() {
+
+	if (!bHasHitTransformable) {
+		if (gunComponent) {
+			gunComponent->SetPowerAvailable(powerIndex);
 		}
 	}
+
+	ReturnToPool();
 }
 
 void AWorkshopUEProjectile::Destroyed() {
 
-	if (!bHasHitTransformable) {
+	// Destroyed in flight (out of the world for example), give back the power.
+	if (!bHasHitTransformable && bInFlight) {
 		if (gunComponent) {
 			gunComponent->SetPowerAvailable(powerIndex);
 		}
 	}
 
+	if (bInFlight) {
+		WORKSHOPUE_ADD_COUNTER(LiveProjectiles, -1);
+		bInFlight = false;
+	}
+
 	Super::Destroyed();
 }
\ No newline at end of file
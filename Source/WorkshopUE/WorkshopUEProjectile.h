@@ -11,7 +11,7 @@
 
 
 UCLASS(config=Game)
-class AWorkshopUEProjectile : public AActor
+class WORKSHOPUE_API AWorkshopUEProjectile : public AActor
 {
 	GENERATED_BODY()
 
@@ -30,8 +30,29 @@ public:
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	/*
+	 * Place the projectile at the muzzle and launch it.
+	 * In batch mode the projectile is simulated by the projectile manager and only used as a visual.
+	 */
+	void Launch(const FVector& location, const FRotator& rotation, bool bSimulateInBatch);
+
+	/* Apply the projectile effect on what was hit, return true if the projectile was consumed. */
+	bool HandleImpact(AActor* OtherActor, UPrimitiveComponent* OtherComp);
+
+	/** Give back the power to the gun if nothing was hit before the end of the lifespan. */
+	void Expire();
+
+	/* Hide the projectile and stop its movement and collision. */
+	void Disable();
+
+	/* Disable the projectile and give it back to its pool. */
+	void ReturnToPool();
+
 	virtual void Destroyed() override;
 
+	/* Launched and not yet returned to the pool. */
+	bool IsInFlight() const { return bInFlight; }
+
 	/** Returns CollisionComp subobject **/
 	FORCEINLINE class USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
@@ -47,5 +68,18 @@ public:
 
 	class UGunComponent* gunComponent;
 	class AWorkshopUECharacter* player;
+
+	/** Pool owning this projectile. */
+	UPROPERTY()
+	class UProjectilePool* pool;
+
+private:
+	FTimerHandle lifespanTimer;
+
+	/* Manager simulating the projectile in batch mode, found on the first batched launch. */
+	TWeakObjectPtr<class AProjectileManager> projectileManager;
+
+	/** Launched and not yet returned to the pool. */
+	bool bInFlight;
 };
 
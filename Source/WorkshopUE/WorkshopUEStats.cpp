@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorkshopUEStats.h"
+#include "WorkshopUE.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RenderCore.h"
+#include "Engine/Engine.h"
+#include "Engine/NetDriver.h"
+
+DEFINE_STAT(STAT_WorkshopUE_Tweens);
+DEFINE_STAT(STAT_WorkshopUE_ApplyTransform);
+DEFINE_STAT(STAT_WorkshopUE_TransformEffect);
+DEFINE_STAT(STAT_WorkshopUE_PutPowerEffect);
+DEFINE_STAT(STAT_WorkshopUE_Reset);
+DEFINE_STAT(STAT_WorkshopUE_Fire);
+DEFINE_STAT(STAT_WorkshopUE_Absorb);
+DEFINE_STAT(STAT_WorkshopUE_ResetTransformables);
+DEFINE_STAT(STAT_WorkshopUE_GunPowers);
+DEFINE_STAT(STAT_WorkshopUE_GunNotifications);
+DEFINE_STAT(STAT_WorkshopUE_BatchedProjectiles);
+
+DEFINE_STAT(STAT_WorkshopUE_ActiveTweens);
+DEFINE_STAT(STAT_WorkshopUE_LiveProjectiles);
+DEFINE_STAT(STAT_WorkshopUE_RegisteredTransformables);
+DEFINE_STAT(STAT_WorkshopUE_DirtyTransformables);
+DEFINE_STAT(STAT_WorkshopUE_ThrottledTweens);
+DEFINE_STAT(STAT_WorkshopUE_NetInBytesPerSecond);
+DEFINE_STAT(STAT_WorkshopUE_NetOutBytesPerSecond);
+DEFINE_STAT(STAT_WorkshopUE_NetConnections);
+DEFINE_STAT(STAT_WorkshopUE_UsedMemoryMB);
+
+// CSV columns, in the order of the enums.
+static const TCHAR* const TimingNames[] = {
+	TEXT("TweensMs"),
+	TEXT("ApplyTransformMs"),
+	TEXT("TransformEffectMs"),
+	TEXT("PutPowerEffectMs"),
+	TEXT("ResetMs"),
+	TEXT("FireMs"),
+	TEXT("AbsorbMs"),
+	TEXT("ResetTransformablesMs"),
+	TEXT("GunPowersMs"),
+	TEXT("GunNotificationsMs"),
+	TEXT("BatchedProjectilesMs"),
+};
+
+static const TCHAR* const CounterNames[] = {
+	TEXT("ActiveTweens"),
+	TEXT("LiveProjectiles"),
+	TEXT("RegisteredTransformables"),
+	TEXT("DirtyTransformables"),
+	TEXT("ThrottledTweens"),
+	TEXT("NetInBytesPerSecond"),
+	TEXT("NetOutBytesPerSecond"),
+	TEXT("NetConnections"),
+	TEXT("UsedMemoryMB"),
+};
+
+static_assert(ARRAY_COUNT(TimingNames) == (int)EWorkshopUECsvTiming::Count, "One column name per timing.");
+static_assert(ARRAY_COUNT(CounterNames) == (int)EWorkshopUECsvCounter::Count, "One column name per counter.");
+
+// Rows buffered before being appended to the file.
+static const int FlushFrames = 600;
+
+// Seconds between two samples of the memory of the process, reading the platform memory stats isn't free.
+static const double MemorySampleInterval = 1.0;
+
+FWorkshopUECsvProfiler& FWorkshopUECsvProfiler::Get()
+{
+	static FWorkshopUECsvProfiler profiler;
+	return profiler;
+}
+
+FWorkshopUECsvProfiler::FWorkshopUECsvProfiler()
+{
+	bCapturing = false;
+	frame = 0;
+
+	FMemory::Memzero(timingCycles);
+	FMemory::Memzero(counters);
+}
+
+void FWorkshopUECsvProfiler::BeginCapture(const FString& fileName)
+{
+	if (bCapturing) {
+		EndCapture();
+	}
+
+	const FString name = fileName.IsEmpty() ? FString::Printf(TEXT("WorkshopUE-%s.csv"), *FDateTime::Now().ToString()) : fileName;
+	path = FPaths::IsRelative(name) ? FPaths::Combine(FPaths::GameSavedDir(), TEXT("Profiling"), TEXT("CSV"), name) : name;
+
+	// Frame time includes the idle time waiting for the next frame, e.g. at the tick rate of a server.
+	pendingRows = TEXT("frame,frameMs,idleMs,gameThreadMs");
+	for (const TCHAR* column : TimingNames) {
+		pendingRows += TEXT(",");
+		pendingRows += column;
+	}
+	for (const TCHAR* column : CounterNames) {
+		pendingRows += TEXT(",");
+		pendingRows += column;
+	}
+	pendingRows += TEXT("\n");
+
+	// Start from an empty file, rows are appended.
+	FFileHelper::SaveStringToFile(FString(), *path);
+
+	frame = 0;
+	FMemory::Memzero(timingCycles);
+	bCapturing = true;
+	endFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FWorkshopUECsvProfiler::EndFrame);
+
+	UE_LOG(LogWorkshopUE, Display, TEXT("CSV capture started: %s"), *path);
+}
+
+void FWorkshopUECsvProfiler::EndCapture()
+{
+	if (!bCapturing) {
+		return;
+	}
+
+	FCoreDelegates::OnEndFrame.Remove(endFrameHandle);
+	bCapturing = false;
+	Flush();
+
+	UE_LOG(LogWorkshopUE, Display, TEXT("CSV capture written: %s (%d frames)"), *path, frame);
+}
+
+void FWorkshopUECsvProfiler::EndFrame()
+{
+	pendingRows += FString::Printf(TEXT("%d,%.3f,%.3f,%.3f"), frame, FApp::GetDeltaTime() * 1000.0, FApp::GetIdleTime() * 1000.0, FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+	for (uint32& cycles : timingCycles) {
+		pendingRows += FString::Printf(TEXT(",%.4f"), FPlatformTime::ToMilliseconds(cycles));
+		cycles = 0;
+	}
+	for (int32 value : counters) {
+		pendingRows += FString::Printf(TEXT(",%d"), value);
+	}
+	pendingRows += TEXT("\n");
+
+	frame++;
+	if (frame % FlushFrames == 0) {
+		Flush();
+	}
+}
+
+void FWorkshopUECsvProfiler::Flush()
+{
+	FFileHelper::SaveStringToFile(pendingRows, *path, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	pendingRows.Reset();
+}
+
+FWorkshopUEProcessStats::FWorkshopUEProcessStats()
+{
+	nextMemorySampleTime = 0.0;
+	usedMemoryMB = 0;
+}
+
+bool FWorkshopUEProcessStats::IsTickable() const
+{
+	if (FWorkshopUECsvProfiler::Get().IsCapturing()) {
+		return true;
+	}
+
+#if STATS
+	return FThreadStats::IsCollectingData(GET_STATID(STAT_WorkshopUE_NetConnections));
+#else
+	return false;
+#endif
+}
+
+void FWorkshopUEProcessStats::Tick(float DeltaTime)
+{
+	uint32 inBytes = 0;
+	uint32 outBytes = 0;
+	int32 connections = 0;
+
+	for (const FWorldContext& context : GEngine->GetWorldContexts())
+	{
+		const UWorld* world = context.World();
+		const UNetDriver* driver = world != nullptr ? world->GetNetDriver() : nullptr;
+
+		if (driver != nullptr) {
+			inBytes += driver->InBytesPerSecond;
+			outBytes += driver->OutBytesPerSecond;
+			connections += driver->ClientConnections.Num();
+		}
+	}
+
+	WORKSHOPUE_SET_COUNTER(NetInBytesPerSecond, inBytes);
+	WORKSHOPUE_SET_COUNTER(NetOutBytesPerSecond, outBytes);
+	WORKSHOPUE_SET_COUNTER(NetConnections, connections);
+
+	const double now = FPlatformTime::Seconds();
+	if (now >= nextMemorySampleTime) {
+		usedMemoryMB = (int32)(FPlatformMemory::GetStats().UsedPhysical / (1024 * 1024));
+		nextMemorySampleTime = now + MemorySampleInterval;
+	}
+	WORKSHOPUE_SET_COUNTER(UsedMemoryMB, usedMemoryMB);
+}
+
+namespace
+{
+	void Csv(const TArray<FString>& args)
+	{
+		if (args.Num() > 0 && args[0] == TEXT("stop")) {
+			FWorkshopUECsvProfiler::Get().EndCapture();
+		}
+		else {
+			FWorkshopUECsvProfiler::Get().BeginCapture(args.Num() > 1 ? args[1] : FString());
+		}
+	}
+
+	FAutoConsoleCommand CsvCommand(
+		TEXT("WorkshopUE.Csv"),
+		TEXT("Capture the WorkshopUE stats to a CSV file in Saved/Profiling/CSV, one row per frame. Arguments: start [file] | stop."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Csv));
+}
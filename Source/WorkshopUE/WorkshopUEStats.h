@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Tickable.h"
+
+/*
+ * Gameplay stats, shown with "stat WorkshopUE" and recorded by "stat startfile".
+ * The same timings and counters are also written once per frame to a CSV capture for headless soak runs,
+ * started with -WorkshopCsv[=<file>] or "WorkshopUE.Csv start [file]", stopped with "WorkshopUE.Csv stop".
+ */
+DECLARE_STATS_GROUP(TEXT("WorkshopUE"), STATGROUP_WorkshopUE, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Transformable tweens"), STAT_WorkshopUE_Tweens, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Transformable apply transform"), STAT_WorkshopUE_ApplyTransform, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Transformable effect"), STAT_WorkshopUE_TransformEffect, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Transformable put power"), STAT_WorkshopUE_PutPowerEffect, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Transformable reset"), STAT_WorkshopUE_Reset, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character fire"), STAT_WorkshopUE_Fire, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character absorb"), STAT_WorkshopUE_Absorb, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character reset transformables"), STAT_WorkshopUE_ResetTransformables, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Gun powers"), STAT_WorkshopUE_GunPowers, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Gun notifications"), STAT_WorkshopUE_GunNotifications, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batched projectiles"), STAT_WorkshopUE_BatchedProjectiles, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active tweens"), STAT_WorkshopUE_ActiveTweens, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live projectiles"), STAT_WorkshopUE_LiveProjectiles, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Registered transformables"), STAT_WorkshopUE_RegisteredTransformables, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Dirty transformables"), STAT_WorkshopUE_DirtyTransformables, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Throttled tweens"), STAT_WorkshopUE_ThrottledTweens, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Net in bytes/s"), STAT_WorkshopUE_NetInBytesPerSecond, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Net out bytes/s"), STAT_WorkshopUE_NetOutBytesPerSecond, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Net client connections"), STAT_WorkshopUE_NetConnections, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Used physical memory MB"), STAT_WorkshopUE_UsedMemoryMB, STATGROUP_WorkshopUE, WORKSHOPUE_API);
+
+/* Timings of the CSV capture, one per cycle stat. */
+enum class EWorkshopUECsvTiming : uint8
+{
+	Tweens,
+	ApplyTransform,
+	TransformEffect,
+	PutPowerEffect,
+	Reset,
+	Fire,
+	Absorb,
+	ResetTransformables,
+	GunPowers,
+	GunNotifications,
+	BatchedProjectiles,
+	Count
+};
+
+/* Counters of the CSV capture, one per counter stat. */
+enum class EWorkshopUECsvCounter : uint8
+{
+	ActiveTweens,
+	LiveProjectiles,
+	RegisteredTransformables,
+	DirtyTransformables,
+	ThrottledTweens,
+	NetInBytesPerSecond,
+	NetOutBytesPerSecond,
+	NetConnections,
+	UsedMemoryMB,
+	Count
+};
+
+/* Per-frame CSV capture of the gameplay stats, available in every build configuration. */
+class WORKSHOPUE_API FWorkshopUECsvProfiler
+{
+public:
+	static FWorkshopUECsvProfiler& Get();
+
+	/* Start writing one row per frame to a file, relative paths are in Saved/Profiling/CSV. */
+	void BeginCapture(const FString& fileName);
+
+	void EndCapture();
+
+	bool IsCapturing() const { return bCapturing; }
+
+	void AddTiming(EWorkshopUECsvTiming timing, uint32 cycles) { timingCycles[(int)timing] += cycles; }
+
+	void SetCounter(EWorkshopUECsvCounter counter, int32 value) { counters[(int)counter] = value; }
+
+	void AddCounter(EWorkshopUECsvCounter counter, int32 delta) { counters[(int)counter] += delta; }
+
+private:
+	FWorkshopUECsvProfiler();
+
+	void EndFrame();
+	void Flush();
+
+	bool bCapturing;
+	FString path;
+	FString pendingRows;
+	int frame;
+
+	FDelegateHandle endFrameHandle;
+
+	uint32 timingCycles[(int)EWorkshopUECsvTiming::Count];
+	int32 counters[(int)EWorkshopUECsvCounter::Count];
+};
+
+/*
+ * Samples the traffic and the connections of the net drivers of the game worlds once per frame
+ * and the memory of the process once per second, owned by the game module.
+ * Only ticks while the CSV capture or the WorkshopUE stat group is on.
+ * Bandwidth of a co-op run on one machine, playing the same puzzle run on the client each time:
+ *	WorkshopUE <map>?listen -WorkshopCsv=host.csv
+ *	WorkshopUE 127.0.0.1 -WorkshopCsv=client.csv
+ */
+class FWorkshopUEProcessStats : public FTickableGameObject
+{
+public:
+	FWorkshopUEProcessStats();
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FWorkshopUEProcessStats, STATGROUP_Tickables); }
+
+private:
+	/* Platform time of the next memory sample, in seconds. */
+	double nextMemorySampleTime;
+
+	int32 usedMemoryMB;
+};
+
+/* Cycles of a scope added to a timing of the CSV capture. */
+class FWorkshopUECsvScope
+{
+public:
+	explicit FWorkshopUECsvScope(EWorkshopUECsvTiming timing)
+		: timing(timing), startCycles(FWorkshopUECsvProfiler::Get().IsCapturing() ? FPlatformTime::Cycles() : 0)
+	{
+	}
+
+	~FWorkshopUECsvScope()
+	{
+		if (startCycles != 0) {
+			FWorkshopUECsvProfiler::Get().AddTiming(timing, FPlatformTime::Cycles() - startCycles);
+		}
+	}
+
+private:
+	EWorkshopUECsvTiming timing;
+	uint32 startCycles;
+};
+
+/* Time a scope in a cycle stat and in the matching timing of the CSV capture, e.g. WORKSHOPUE_SCOPE_CYCLE(Fire). */
+#define WORKSHOPUE_SCOPE_CYCLE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_WorkshopUE_##Name); \
+	FWorkshopUECsvScope PREPROCESSOR_JOIN(csvScope, __LINE__)(EWorkshopUECsvTiming::Name)
+
+/* Set a counter stat and the matching counter of the CSV capture. */
+#define WORKSHOPUE_SET_COUNTER(Name, Value) \
+	SET_DWORD_STAT(STAT_WorkshopUE_##Name, Value); \
+	FWorkshopUECsvProfiler::Get().SetCounter(EWorkshopUECsvCounter::Name, Value)
+
+/* Add to a counter stat and to the matching counter of the CSV capture. */
+#define WORKSHOPUE_ADD_COUNTER(Name, Delta) \
+	INC_DWORD_STAT_BY(STAT_WorkshopUE_##Name, Delta); \
+	FWorkshopUECsvProfiler::Get().AddCounter(EWorkshopUECsvCounter::Name, Delta)
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+/* Find the manager actor of the given class in a world, spawn it if it doesn't exist yet. */
+template<class T>
+T* FindOrSpawnWorldManager(UWorld* world)
+{
+	if (world == nullptr) {
+		return nullptr;
+	}
+
+	for (TActorIterator<T> it(world); it; ++it) {
+		if (!it->IsPendingKill()) {
+			return *it;
+		}
+	}
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	spawnParams.ObjectFlags |= RF_Transient;
+
+	return world->SpawnActor<T>(spawnParams);
+}
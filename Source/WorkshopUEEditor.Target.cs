@@ -9,5 +9,6 @@ public class WorkshopUEEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 		ExtraModuleNames.Add("WorkshopUE");
+		ExtraModuleNames.Add("WorkshopUETests");
 	}
 }
@@ -0,0 +1,338 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorkshopUETests.h"
+#include "WorkshopUECharacter.h"
+#include "WorkshopUEProjectile.h"
+#include "Transformable.h"
+#include "TransformableManager.h"
+#include "GunComponent.h"
+#include "EngineUtils.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/Engine.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+/*
+ * Benchmarks of the gameplay hot paths, run by the WorkshopUE.Bench automation test in the loaded map.
+ * Transformables are spawned out of the way and destroyed at the end, the gun of the player is restored.
+ * Results are logged and written as JSON to Saved/Benchmarks.
+ */
+class FWorkshopUEBenchmarks
+{
+public:
+	FWorkshopUEBenchmarks(UWorld* world, int count, int iterations)
+		: world(world), count(count), iterations(iterations), manager(nullptr), character(nullptr)
+	{
+	}
+
+	/* Return false if there is no world to run in. */
+	bool Run()
+	{
+		manager = ATransformableManager::Get(world);
+		character = Cast<AWorkshopUECharacter>(UGameplayStatics::GetPlayerCharacter(world, 0));
+
+		if (manager == nullptr) {
+			return false;
+		}
+
+		SpawnTransformables();
+
+		BenchManagerTick();
+		BenchPutPowerEffect();
+		BenchResetTransformables();
+
+		if (character != nullptr && character->gunComponent != nullptr) {
+			BenchGun();
+		}
+		else {
+			UE_LOG(LogWorkshopUETests, Warning, TEXT("Bench: no player character, gun benchmarks skipped"));
+		}
+
+		for (ATransformable* transformable : transformables) {
+			transformable->Destroy();
+		}
+
+		WriteReport();
+		return true;
+	}
+
+private:
+	struct FResult
+	{
+		FString name;
+		int operations;
+		TArray<double> samples;	// ms per iteration
+	};
+
+	UWorld* world;
+	int count;
+	int iterations;
+
+	ATransformableManager* manager;
+	AWorkshopUECharacter* character;
+	TArray<ATransformable*> transformables;
+	TArray<FResult> results;
+
+	/* Time body once per iteration, operations is the work done by one call. */
+	template<typename FBody>
+	void Measure(const TCHAR* name, int operations, FBody body)
+	{
+		FResult& result = results[results.AddDefaulted()];
+		result.name = name;
+		result.operations = operations;
+
+		for (int i = 0; i < iterations; i++)
+		{
+			const double start = FPlatformTime::Seconds();
+			body();
+			result.samples.Add((FPlatformTime::Seconds() - start) * 1000.0);
+		}
+	}
+
+	void SpawnTransformables()
+	{
+		// Use the class placed in the level, it has the meshes and the collision of the real transformables.
+		UClass* transformableClass = ATransformable::StaticClass();
+		for (TActorIterator<ATransformable> it(world); it; ++it) {
+			transformableClass = it->GetClass();
+			break;
+		}
+
+		const int side = FMath::CeilToInt(FMath::Sqrt((float)count));
+
+		for (int i = 0; i < count; i++)
+		{
+			// High above the level, far enough from each other to be in different grid cells.
+			const FTransform transform(FVector((i % side) * 1000.0f, (i / side) * 1000.0f, 100000.0f));
+
+			ATransformable* transformable = world->SpawnActorDeferred<ATransformable>(transformableClass, transform, nullptr, nullptr,
+				ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+
+			// The native class has no component, give it a root to move.
+			if (transformable->GetRootComponent() == nullptr) {
+				USceneComponent* root = NewObject<USceneComponent>(transformable, TEXT("Root"));
+				root->SetMobility(EComponentMobility::Movable);
+				transformable->SetRootComponent(root);
+				root->RegisterComponent();
+			}
+
+			// Tweens stay active during the whole run.
+			transformable->timeToChange = 1000.0f;
+
+			UGameplayStatics::FinishSpawningActor(transformable, transform);
+			transformables.Add(transformable);
+		}
+	}
+
+	void BenchManagerTick()
+	{
+		const float deltaTime = 1.0f / 60.0f;
+
+		// Idle transformables don't tick, only the manager does while tweens are active.
+		for (ATransformable* transformable : transformables) {
+			manager->StopTweens(transformable);
+		}
+
+		Measure(TEXT("TickIdle"), count, [&]() { manager->Tick(deltaTime); });
+
+		for (ATransformable* transformable : transformables) {
+			transformable->TransformEffect(0, nullptr);
+		}
+
+		// Every tween written back, then with the significance of the camera, the transformables are far out of view.
+		const bool bUseSignificance = manager->bUseSignificance;
+
+		manager->bUseSignificance = false;
+		Measure(TEXT("TickActive"), count, [&]() { manager->Tick(deltaTime); });
+
+		manager->bUseSignificance = true;
+		Measure(TEXT("TickActiveSignificance"), count, [&]() { manager->Tick(deltaTime); });
+
+		manager->bUseSignificance = bUseSignificance;
+	}
+
+	void BenchPutPowerEffect()
+	{
+		// Standalone gun, the power is passed from transformable to transformable.
+		UGunComponent* gun = NewObject<UGunComponent>(manager);
+		gun->GetPowers().GetStates().values[0] = Powers::GetEffect(0);
+
+		Measure(TEXT("PutPowerEffect"), count, [&]()
+		{
+			for (ATransformable* transformable : transformables) {
+				transformable->PutPowerEffect(0, gun);
+			}
+		});
+	}
+
+	void BenchResetTransformables()
+	{
+		FResult& result = results[results.AddDefaulted()];
+		result.name = TEXT("RestoreBaseline");
+		result.operations = count;
+
+		for (int i = 0; i < iterations; i++)
+		{
+			for (ATransformable* transformable : transformables) {
+				transformable->TransformEffect(1, nullptr);
+			}
+
+			const double start = FPlatformTime::Seconds();
+			manager->RestoreBaseline(nullptr, 0);
+			result.samples.Add((FPlatformTime::Seconds() - start) * 1000.0);
+		}
+	}
+
+	void BenchGun()
+	{
+		UGunComponent* gun = character->gunComponent;
+
+		const FGunPowers savedPowers = gun->GetPowers();
+
+		gun->SetEquipped(true);
+		gun->GetPowers().GetStates().unlockedMask = Powers::AllMask;
+		gun->SwitchToPower(0);
+
+		Measure(TEXT("NextPower"), count, [&]()
+		{
+			for (int i = 0; i < count; i++) {
+				gun->NextPower();
+			}
+		});
+
+		Measure(TEXT("PreviousPower"), count, [&]()
+		{
+			for (int i = 0; i < count; i++) {
+				gun->PreviousPower();
+			}
+		});
+
+		gun->SwitchToPower(0);
+
+		if (gun->ProjectileClasses.IsValidIndex(0) && gun->ProjectileClasses[0] != nullptr) {
+			BenchFire(gun);
+		}
+		else {
+			UE_LOG(LogWorkshopUETests, Warning, TEXT("Bench: the gun has no projectile class, OnFire skipped"));
+		}
+
+		gun->GetPowers() = savedPowers;
+		for (int i = 0; i < Powers::Count; i++) {
+			gun->MarkPowerChanged(i);
+		}
+	}
+
+	void BenchFire(UGunComponent* gun)
+	{
+		// One pool worth of shots, then every projectile goes back to the pool.
+		const int batch = FMath::Max(gun->projectilePoolSize, 1);
+
+		FResult& result = results[results.AddDefaulted()];
+		result.name = TEXT("OnFireCycle");
+		result.operations = batch;
+
+		for (int i = 0; i < iterations; i++)
+		{
+			double elapsed = 0.0;
+
+			double start = FPlatformTime::Seconds();
+			for (int shot = 0; shot < batch; shot++) {
+				gun->SetPowerAvailable(0);
+				character->OnFire();
+			}
+			elapsed += FPlatformTime::Seconds() - start;
+
+			// Finding the projectiles is not part of the cycle.
+			TArray<AWorkshopUEProjectile*> inFlight;
+			for (TActorIterator<AWorkshopUEProjectile> it(world); it; ++it) {
+				if (it->IsInFlight() && it->gunComponent == gun) {
+					inFlight.Add(*it);
+				}
+			}
+
+			start = FPlatformTime::Seconds();
+			for (AWorkshopUEProjectile* projectile : inFlight) {
+				projectile->Expire();
+			}
+			elapsed += FPlatformTime::Seconds() - start;
+
+			result.samples.Add(elapsed * 1000.0);
+		}
+	}
+
+	void WriteReport() const
+	{
+		FString json = FString::Printf(TEXT("{\n\t\"map\": \"%s\",\n\t\"date\": \"%s\",\n\t\"transformables\": %d,\n\t\"iterations\": %d,\n\t\"results\": [\n"),
+			*world->GetMapName(), *FDateTime::UtcNow().ToIso8601(), count, iterations);
+
+		for (int i = 0; i < results.Num(); i++)
+		{
+			TArray<double> sorted = results[i].samples;
+			sorted.Sort();
+
+			const double median = sorted[sorted.Num() / 2];
+			const double nsPerOperation = median * 1000000.0 / FMath::Max(results[i].operations, 1);
+
+			UE_LOG(LogWorkshopUETests, Display, TEXT("Bench %-20s %8d ops: median %.3f ms (min %.3f, max %.3f), %.1f ns/op"),
+				*results[i].name, results[i].operations, median, sorted[0], sorted.Last(), nsPerOperation);
+
+			json += FString::Printf(TEXT("\t\t{ \"name\": \"%s\", \"operations\": %d, \"medianMs\": %.4f, \"minMs\": %.4f, \"maxMs\": %.4f, \"nsPerOperation\": %.2f }%s\n"),
+				*results[i].name, results[i].operations, median, sorted[0], sorted.Last(), nsPerOperation, i + 1 < results.Num() ? TEXT(",") : TEXT(""));
+		}
+
+		json += TEXT("\t]\n}\n");
+
+		const FString path = FPaths::Combine(FPaths::GameSavedDir(), TEXT("Benchmarks"),
+			FString::Printf(TEXT("WorkshopUE-%s.json"), *FDateTime::Now().ToString()));
+
+		if (FFileHelper::SaveStringToFile(json, *path)) {
+			UE_LOG(LogWorkshopUETests, Display, TEXT("Bench report written to %s"), *path);
+		}
+	}
+};
+
+namespace
+{
+	/* Game world of the running game or of the play in editor session, nullptr if none. */
+	UWorld* FindGameWorld()
+	{
+		for (const FWorldContext& context : GEngine->GetWorldContexts())
+		{
+			if ((context.WorldType == EWorldType::Game || context.WorldType == EWorldType::PIE) && context.World() != nullptr) {
+				return context.World();
+			}
+		}
+		return nullptr;
+	}
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FWorkshopUEBenchTest, "WorkshopUE.Bench",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+/* One test per number of transformables, the parameters are "<transformables> <iterations>". */
+void FWorkshopUEBenchTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	OutBeautifiedNames.Add(TEXT("1000 transformables"));
+	OutTestCommands.Add(TEXT("1000 20"));
+
+	OutBeautifiedNames.Add(TEXT("10000 transformables"));
+	OutTestCommands.Add(TEXT("10000 10"));
+}
+
+bool FWorkshopUEBenchTest::RunTest(const FString& Parameters)
+{
+	TArray<FString> args;
+	Parameters.ParseIntoArrayWS(args);
+
+	const int count = args.Num() > 0 ? FMath::Max(FCString::Atoi(*args[0]), 1) : 1000;
+	const int iterations = args.Num() > 1 ? FMath::Max(FCString::Atoi(*args[1]), 1) : 20;
+
+	UWorld* world = FindGameWorld();
+	if (world == nullptr || !FWorkshopUEBenchmarks(world, count, iterations).Run()) {
+		AddError(TEXT("No game world to run in, load a map with -game or start a play in editor session."));
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using System.IO;
+using UnrealBuildTool;
+
+public class WorkshopUETests : ModuleRules
+{
+	public WorkshopUETests(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "WorkshopUE" });
+
+		// The game module keeps its headers next to its sources.
+		PrivateIncludePaths.Add(Path.Combine(ModuleDirectory, "..", "WorkshopUE"));
+	}
+}
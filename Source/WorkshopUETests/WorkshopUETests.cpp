@@ -0,0 +1,13 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WorkshopUETests.h"
+#include "Modules/ModuleManager.h"
+
+/*
+ * Automation tests of the game, only built with the editor.
+ * Run headless from the editor binary, e.g.
+ * UE4Editor-Cmd WorkshopUE.uproject <map> -game -nullrhi -unattended -ExecCmds="Automation RunTests WorkshopUE; Quit"
+ */
+IMPLEMENT_MODULE(FDefaultModuleImpl, WorkshopUETests);
+
+DEFINE_LOG_CATEGORY(LogWorkshopUETests);